@@ -1 +1,154 @@
 #pragma once
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace qsb { namespace ranges_detail {
+// -----------------------------------------------------------------------------
+//  is_span
+// -----------------------------------------------------------------------------
+	template <typename T>
+	struct is_span_impl : std::false_type {};
+
+// -----------------------------------------------------------------------------
+//  is_array_convertible
+// -----------------------------------------------------------------------------
+	// U* is convertible to T* only by qualification conversion (ex. int* -> const int*)
+	template <typename U, typename T>
+	using is_array_convertible = std::is_convertible<U(*)[], T(*)[]>;
+
+// -----------------------------------------------------------------------------
+//  contiguous_element_t
+// -----------------------------------------------------------------------------
+	template <typename C>
+	using contiguous_element_t = std::remove_pointer_t<decltype(std::data(std::declval<C&>()))>;
+
+}} // namespace qsb::ranges_detail
+
+namespace qsb {
+// -----------------------------------------------------------------------------
+//  span
+// -----------------------------------------------------------------------------
+	/*
+		Non-owning view of a contiguous sequence.
+		This is a subset of C++20 std::span with dynamic extent,
+		and can be replaced with std::span after introducing C++20.
+
+		ex)
+			std::vector<double> values(10);
+			qsb::span<double> s = values;
+			qsb::span<const double> cs = s;
+	*/
+	template <typename T>
+	class span {
+	private:
+		using this_type = span;
+
+	public:
+		using element_type = T;
+		using value_type = std::remove_cv_t<T>;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = T*;
+		using reference = T&;
+		using iterator = T*;
+
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		constexpr span() noexcept = default;
+		constexpr span(const this_type&) noexcept = default;
+
+		constexpr span(T* data, std::size_t size) noexcept
+			: data_(data), size_(size)
+		{
+		}
+
+		template <std::size_t N>
+		constexpr span(T (&arr)[N]) noexcept
+			: data_(arr), size_(N)
+		{
+		}
+
+		template <typename C, std::enable_if_t<
+			!ranges_detail::is_span_impl<std::remove_cv_t<C>>::value &&
+			!std::is_array_v<C> &&
+			ranges_detail::is_array_convertible<ranges_detail::contiguous_element_t<C>, T>::value,
+		std::nullptr_t> = nullptr>
+		constexpr span(C& container) noexcept(noexcept(std::data(container)) && noexcept(std::size(container)))
+			: data_(std::data(container)), size_(std::size(container))
+		{
+		}
+
+		template <typename U, std::enable_if_t<
+			!std::is_same_v<U, T> && ranges_detail::is_array_convertible<U, T>::value,
+		std::nullptr_t> = nullptr>
+		constexpr span(const span<U>& other) noexcept
+			: data_(other.data()), size_(other.size())
+		{
+		}
+
+	// -------------------------------------------------------------------------
+	//  assignments
+	//
+		constexpr this_type& operator =(const this_type&) noexcept = default;
+
+	// -------------------------------------------------------------------------
+	//  get
+	//
+		constexpr T* data() const noexcept { return data_; }
+		constexpr std::size_t size() const noexcept { return size_; }
+		constexpr bool empty() const noexcept { return size_ == 0; }
+
+		constexpr T& operator [](std::size_t i) const noexcept { return data_[i]; }
+		constexpr T& front() const noexcept { return data_[0]; }
+		constexpr T& back() const noexcept { return data_[size_ - 1]; }
+
+		constexpr iterator begin() const noexcept { return data_; }
+		constexpr iterator end() const noexcept { return data_ + size_; }
+
+	// -------------------------------------------------------------------------
+	//  subviews
+	//
+		constexpr this_type first(std::size_t count) const noexcept
+		{
+			return this_type(data_, count);
+		}
+
+		constexpr this_type last(std::size_t count) const noexcept
+		{
+			return this_type(data_ + (size_ - count), count);
+		}
+
+		constexpr this_type subspan(std::size_t offset, std::size_t count) const noexcept
+		{
+			return this_type(data_ + offset, count);
+		}
+
+		constexpr this_type subspan(std::size_t offset) const noexcept
+		{
+			return this_type(data_ + offset, size_ - offset);
+		}
+
+	private:
+		T* data_ = nullptr;
+		std::size_t size_ = 0;
+
+	}; // class span
+
+	template <typename T, std::size_t N>
+	span(T (&)[N]) -> span<T>;
+
+	template <typename C>
+	span(C&) -> span<ranges_detail::contiguous_element_t<C>>;
+
+} // namespace qsb
+
+namespace qsb { namespace ranges_detail {
+// -----------------------------------------------------------------------------
+//  is_span
+// -----------------------------------------------------------------------------
+	template <typename T>
+	struct is_span_impl<span<T>> : std::true_type {};
+
+}} // namespace qsb::ranges_detail
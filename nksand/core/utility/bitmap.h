@@ -0,0 +1,188 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace qsb { namespace util {
+// -----------------------------------------------------------------------------
+//  bitmap
+// -----------------------------------------------------------------------------
+	/*
+		Dynamically sized sequence of bits packed into 64bit words.
+		This is used as a validity mask of columnar data,
+		ex. bit i of util::from_string_batch result tells whether field i is converted.
+
+		Bits beyond size() in the last word are always kept zero,
+		so words can be combined or counted directly.
+
+		ex)
+			qsb::util::bitmap valid(100);
+			valid.set(3);
+			valid.test(3);	// true
+			valid.count();	// 1
+	*/
+	class bitmap {
+	private:
+		using this_type = bitmap;
+
+	public:
+		using word_type = std::uint64_t;
+		static constexpr std::size_t word_bits = 64;
+
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		bitmap() = default;
+
+		explicit bitmap(std::size_t size, bool value = false)
+			: words_(this_type::word_count_of(size), value ? ~word_type(0) : word_type(0)), size_(size)
+		{
+			this->clear_tail();
+		}
+
+	// -------------------------------------------------------------------------
+	//  size
+	//
+		std::size_t size() const noexcept { return size_; }
+		bool empty() const noexcept { return size_ == 0; }
+
+		void resize(std::size_t size, bool value = false)
+		{
+			const std::size_t old_size = size_;
+			words_.resize(this_type::word_count_of(size), value ? ~word_type(0) : word_type(0));
+			size_ = size;
+			if (value && old_size < size && old_size % word_bits != 0) {
+				words_[old_size / word_bits] |= ~word_type(0) << (old_size % word_bits);
+			}
+			this->clear_tail();
+		}
+
+		void reserve(std::size_t size)
+		{
+			words_.reserve(this_type::word_count_of(size));
+		}
+
+		void assign(std::size_t size, bool value)
+		{
+			words_.assign(this_type::word_count_of(size), value ? ~word_type(0) : word_type(0));
+			size_ = size;
+			this->clear_tail();
+		}
+
+		void clear() noexcept
+		{
+			words_.clear();
+			size_ = 0;
+		}
+
+	// -------------------------------------------------------------------------
+	//  bit access
+	//
+		bool test(std::size_t i) const noexcept
+		{
+			return (words_[i / word_bits] >> (i % word_bits)) & 1u;
+		}
+
+		bool operator [](std::size_t i) const noexcept
+		{
+			return this->test(i);
+		}
+
+		void set(std::size_t i, bool value = true) noexcept
+		{
+			const word_type bit = word_type(1) << (i % word_bits);
+			word_type& word = words_[i / word_bits];
+			word = value ? (word | bit) : (word & ~bit);
+		}
+
+		void reset(std::size_t i) noexcept
+		{
+			this->set(i, false);
+		}
+
+	// -------------------------------------------------------------------------
+	//  word access
+	//
+		std::size_t word_count() const noexcept { return words_.size(); }
+		const word_type* words() const noexcept { return words_.data(); }
+
+		word_type word(std::size_t word_index) const noexcept
+		{
+			return words_[word_index];
+		}
+
+		// bits of the word beyond size() are ignored
+		void set_word(std::size_t word_index, word_type word) noexcept
+		{
+			words_[word_index] = word;
+			if (word_index + 1 == words_.size()) {
+				this->clear_tail();
+			}
+		}
+
+	// -------------------------------------------------------------------------
+	//  aggregation
+	//
+		std::size_t count() const noexcept
+		{
+			std::size_t result = 0;
+			for (word_type word : words_) {
+				result += this_type::popcount(word);
+			}
+			return result;
+		}
+
+		bool all() const noexcept { return this->count() == size_; }
+		bool any() const noexcept { return !this->none(); }
+
+		bool none() const noexcept
+		{
+			for (word_type word : words_) {
+				if (word != 0) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+	// -------------------------------------------------------------------------
+	//  comparison
+	//
+		friend bool operator ==(const this_type& l, const this_type& r) noexcept
+		{
+			return l.size_ == r.size_ && l.words_ == r.words_;
+		}
+
+		friend bool operator !=(const this_type& l, const this_type& r) noexcept
+		{
+			return !(l == r);
+		}
+
+	private:
+		static constexpr std::size_t word_count_of(std::size_t size) noexcept
+		{
+			return (size + word_bits - 1) / word_bits;
+		}
+
+		static std::size_t popcount(word_type word) noexcept
+		{
+			word = word - ((word >> 1) & 0x5555555555555555ull);
+			word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+			word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+			return static_cast<std::size_t>((word * 0x0101010101010101ull) >> 56);
+		}
+
+		void clear_tail() noexcept
+		{
+			if (size_ % word_bits != 0) {
+				words_.back() &= ~(~word_type(0) << (size_ % word_bits));
+			}
+		}
+
+	private:
+		std::vector<word_type> words_;
+		std::size_t size_ = 0;
+
+	}; // class bitmap
+
+}} // namespace qsb::util
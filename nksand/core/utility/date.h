@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include "from_str.h"
+#include "detail/date.h"
+
+namespace qsb {
+// -----------------------------------------------------------------------------
+//  date
+// -----------------------------------------------------------------------------
+	/*
+		Calendar date held as a serial day number, i.e. days since 1970-01-01.
+		Differences and comparisons of dates are those of integers.
+
+		from_string_trait accepts "YYYY-MM-DD" and "YYYYMMDD"
+		without std::tm, mktime or locale, and to_string writes "YYYY-MM-DD".
+		Use util::from_string_batch for columns of dates.
+
+		ex)
+			const auto d = qsb::util::from_string<qsb::date>("2024-03-15");
+			d.serial();		// 19797
+			d.year();		// 2024
+			qsb::util::to_string(d + 1);	// "2024-03-16"
+	*/
+	class date {
+	private:
+		using this_type = date;
+
+	public:
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		constexpr date() noexcept = default;
+
+		// y-m-d must be a valid date
+		constexpr date(std::int32_t y, unsigned m, unsigned d) noexcept
+			: serial_(date_detail::days_from_civil(y, m, d))
+		{
+		}
+
+		static constexpr this_type from_serial(std::int32_t serial) noexcept
+		{
+			this_type result;
+			result.serial_ = serial;
+			return result;
+		}
+
+	// -------------------------------------------------------------------------
+	//  get
+	//
+		constexpr std::int32_t serial() const noexcept { return serial_; }
+		constexpr std::int32_t year() const noexcept { return date_detail::civil_from_days(serial_).year; }
+		constexpr unsigned month() const noexcept { return date_detail::civil_from_days(serial_).month; }
+		constexpr unsigned day() const noexcept { return date_detail::civil_from_days(serial_).day; }
+
+		std::string to_string() const
+		{
+			const auto ymd = date_detail::civil_from_days(serial_);
+			char buffer[32];
+			const int size = std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u", static_cast<int>(ymd.year), ymd.month, ymd.day);
+			return std::string(buffer, static_cast<std::size_t>(size));
+		}
+
+	// -------------------------------------------------------------------------
+	//  arithmetic
+	//
+		friend constexpr this_type operator +(const this_type& l, std::int32_t days) noexcept { return this_type::from_serial(l.serial_ + days); }
+		friend constexpr this_type operator -(const this_type& l, std::int32_t days) noexcept { return this_type::from_serial(l.serial_ - days); }
+		friend constexpr std::int32_t operator -(const this_type& l, const this_type& r) noexcept { return l.serial_ - r.serial_; }
+
+	// -------------------------------------------------------------------------
+	//  comparison
+	//
+		friend constexpr bool operator ==(const this_type& l, const this_type& r) noexcept { return l.serial_ == r.serial_; }
+		friend constexpr bool operator !=(const this_type& l, const this_type& r) noexcept { return l.serial_ != r.serial_; }
+		friend constexpr bool operator <(const this_type& l, const this_type& r) noexcept { return l.serial_ < r.serial_; }
+		friend constexpr bool operator >(const this_type& l, const this_type& r) noexcept { return l.serial_ > r.serial_; }
+		friend constexpr bool operator <=(const this_type& l, const this_type& r) noexcept { return l.serial_ <= r.serial_; }
+		friend constexpr bool operator >=(const this_type& l, const this_type& r) noexcept { return l.serial_ >= r.serial_; }
+
+	private:
+		std::int32_t serial_ = 0;
+
+	}; // class date
+
+} // namespace qsb
+
+namespace qsb { namespace traits {
+// -----------------------------------------------------------------------------
+//  from_string_trait<date>
+// -----------------------------------------------------------------------------
+	template <>
+	struct from_string_trait<date> {
+	private:
+		using this_type = from_string_trait;
+
+	public:
+		static from_string_errc try_apply(std::string_view str, date& out) noexcept
+		{
+			std::int32_t serial = 0;
+			const auto ec = date_detail::parse_date(str, serial);
+			if (ec == from_string_errc::ok) {
+				out = date::from_serial(serial);
+			}
+			return ec;
+		}
+
+		static date apply(std::string_view str)
+		{
+			date result;
+			from_str_detail::throw_if_failed(this_type::try_apply(str, result));
+			return result;
+		}
+
+		static std::size_t try_apply_batch(span<const std::string_view> strs, span<date> out, util::bitmap& valid) noexcept
+		{
+			return date_detail::parse_date_batch(strs, out, valid);
+		}
+	};
+
+}} // namespace qsb::traits
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+namespace qsb { namespace bit_detail {
+// -----------------------------------------------------------------------------
+//  bit_width
+// -----------------------------------------------------------------------------
+	// number of bits to represent value, 0 for 0
+	inline int bit_width(std::uint64_t value) noexcept
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		return _BitScanReverse64(&index, value) ? static_cast<int>(index) + 1 : 0;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) {
+			return static_cast<int>(index) + 33;
+		}
+		return _BitScanReverse(&index, static_cast<unsigned long>(value)) ? static_cast<int>(index) + 1 : 0;
+#else
+		return value == 0 ? 0 : 64 - __builtin_clzll(value);
+#endif
+	}
+
+// -----------------------------------------------------------------------------
+//  countr_zero
+// -----------------------------------------------------------------------------
+	// number of trailing zero bits, 64 for 0
+	inline int countr_zero(std::uint64_t value) noexcept
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		return _BitScanForward64(&index, value) ? static_cast<int>(index) : 64;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, static_cast<unsigned long>(value))) {
+			return static_cast<int>(index);
+		}
+		return _BitScanForward(&index, static_cast<unsigned long>(value >> 32)) ? static_cast<int>(index) + 32 : 64;
+#else
+		return value == 0 ? 64 : __builtin_ctzll(value);
+#endif
+	}
+
+}} // namespace qsb::bit_detail
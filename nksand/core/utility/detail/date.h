@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "../../ranges.h"
+#include "../bitmap.h"
+#include "parse_digits.h"
+
+namespace qsb { namespace date_detail {
+// -----------------------------------------------------------------------------
+//  civil calendar
+// -----------------------------------------------------------------------------
+	/*
+		Conversion between proleptic Gregorian dates and days since 1970-01-01.
+		(H. Hinnant, "chrono-Compatible Low-Level Date Algorithms")
+		Both are branch free except for the sign handling of eras.
+	*/
+	constexpr std::int32_t days_from_civil(std::int32_t y, unsigned m, unsigned d) noexcept
+	{
+		y -= m <= 2 ? 1 : 0;
+		const std::int32_t era = (y >= 0 ? y : y - 399) / 400;
+		const auto yoe = static_cast<unsigned>(y - era * 400);				// [0, 399]
+		const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;	// [0, 365]
+		const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;			// [0, 146096]
+		return era * 146097 + static_cast<std::int32_t>(doe) - 719468;
+	}
+
+	struct civil {
+		std::int32_t year;
+		unsigned month;
+		unsigned day;
+	};
+
+	constexpr civil civil_from_days(std::int32_t z) noexcept
+	{
+		z += 719468;
+		const std::int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+		const auto doe = static_cast<unsigned>(z - era * 146097);					// [0, 146096]
+		const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;	// [0, 399]
+		const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);				// [0, 365]
+		const unsigned mp = (5 * doy + 2) / 153;									// [0, 11]
+		const unsigned d = doy - (153 * mp + 2) / 5 + 1;							// [1, 31]
+		const unsigned m = mp < 10 ? mp + 3 : mp - 9;								// [1, 12]
+		const std::int32_t y = static_cast<std::int32_t>(yoe) + era * 400 + (m <= 2 ? 1 : 0);
+		return { y, m, d };
+	}
+
+	constexpr bool is_leap_year(std::int32_t y) noexcept
+	{
+		return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+	}
+
+	constexpr unsigned last_day_of_month(std::int32_t y, unsigned m) noexcept
+	{
+		constexpr unsigned char days[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+		return days[m] + (m == 2 && date_detail::is_leap_year(y) ? 1u : 0u);
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_date
+// -----------------------------------------------------------------------------
+	/*
+		Accepted formats are "YYYY-MM-DD" and "YYYYMMDD".
+		The extended format is rearranged into the basic one in a register,
+		and the 8 digits are validated and converted by SWAR at once.
+		Dates which do not exist, such as 2023-02-29, are rejected.
+		out_serial is untouched unless ok is returned.
+	*/
+	inline traits::from_string_errc parse_date(std::string_view str, std::int32_t& out_serial) noexcept
+	{
+		std::uint64_t word = 0;
+		bool separators = true;
+		if (str.size() == 10) {
+			// "YYYY-MM-" and "DD" -> "YYYYMMDD"
+			const std::uint64_t head = from_str_detail::load_u64(str.data());
+			std::uint16_t tail = 0;
+			std::memcpy(&tail, str.data() + 8, sizeof(tail));
+			separators = ((head >> 32) & 0xFF) == '-' && (head >> 56) == '-';
+			word = (head & 0x00000000FFFFFFFFull) | ((head >> 8) & 0x0000FFFF00000000ull) | (std::uint64_t(tail) << 48);
+		}
+		else if (str.size() == 8) {
+			word = from_str_detail::load_u64(str.data());
+		}
+		else {
+			return traits::from_string_errc::invalid_argument;
+		}
+		if (!separators || !from_str_detail::is_eight_digits(word)) {
+			return traits::from_string_errc::invalid_argument;
+		}
+
+		const std::uint32_t ymd = from_str_detail::parse_eight_digits(word);
+		const auto y = static_cast<std::int32_t>(ymd / 10000);
+		const unsigned m = ymd / 100 % 100;
+		const unsigned d = ymd % 100;
+		if (m - 1u >= 12u || d == 0 || d > date_detail::last_day_of_month(y, m)) {
+			return traits::from_string_errc::invalid_argument;
+		}
+		out_serial = date_detail::days_from_civil(y, m, d);
+		return traits::from_string_errc::ok;
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_date_batch
+// -----------------------------------------------------------------------------
+	/*
+		Columnar version of parse_date.
+		Validity bits are accumulated into a word and stored once per 64 fields.
+		The output type must be constructible by T::from_serial(std::int32_t).
+	*/
+	template <typename T>
+	std::size_t parse_date_batch(span<const std::string_view> strs, span<T> out, util::bitmap& valid) noexcept
+	{
+		using word_type = util::bitmap::word_type;
+		constexpr std::size_t word_bits = util::bitmap::word_bits;
+
+		const std::size_t size = strs.size();
+		for (std::size_t head = 0; head < size; head += word_bits) {
+			const std::size_t tail = size - head < word_bits ? size : head + word_bits;
+			word_type word = 0;
+			for (std::size_t i = head; i < tail; ++i) {
+				std::int32_t serial = 0;
+				const bool ok = date_detail::parse_date(strs[i], serial) == traits::from_string_errc::ok;
+				if (ok) {
+					out[i] = T::from_serial(serial);
+				}
+				word |= word_type(ok) << (i - head);
+			}
+			valid.set_word(head / word_bits, word);
+		}
+		return valid.count();
+	}
+
+}} // namespace qsb::date_detail
@@ -0,0 +1,175 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "../../ranges.h"
+#include "../bitmap.h"
+#include "from_str.h"
+#include "parse_digits.h"
+
+namespace qsb { namespace from_str_detail {
+// -----------------------------------------------------------------------------
+//  pow10_i64
+// -----------------------------------------------------------------------------
+	constexpr std::int64_t pow10_i64(std::size_t n) noexcept
+	{
+		std::int64_t result = 1;
+		for (std::size_t i = 0; i < n; ++i) {
+			result *= 10;
+		}
+		return result;
+	}
+
+// -----------------------------------------------------------------------------
+//  stage_fixed
+// -----------------------------------------------------------------------------
+	/*
+		Checks the shape of a fixed format field
+			[+|-]d{1, IntegerDigits}.d{FractionDigits}	(no '.' when FractionDigits is 0)
+		and copies its digits right aligned into a '0' padded buffer.
+		Digits are validated by two SWAR checks on the buffer instead of a loop over characters.
+	*/
+	template <std::size_t IntegerDigits, std::size_t FractionDigits>
+	bool stage_fixed(std::string_view str, char (&digits)[16], bool& negative) noexcept
+	{
+		static_assert(IntegerDigits + FractionDigits <= 16, "at most 16 digits are supported.");
+		constexpr std::size_t tail = FractionDigits == 0 ? 0 : FractionDigits + 1;
+
+		const std::size_t size = str.size();
+		const std::size_t sign = size != 0 && (str[0] == '-' || str[0] == '+') ? 1 : 0;
+		if (size < sign + 1 + tail || size > sign + IntegerDigits + tail) {
+			return false;
+		}
+		if (FractionDigits != 0 && str[size - tail] != '.') {
+			return false;
+		}
+
+		const std::size_t integer_count = size - sign - tail;
+		std::memset(digits, '0', sizeof(digits));
+		std::memcpy(digits + 16 - FractionDigits - integer_count, str.data() + sign, integer_count);
+		std::memcpy(digits + 16 - FractionDigits, str.data() + size - FractionDigits, FractionDigits);
+		negative = str[0] == '-';
+		return from_str_detail::is_eight_digits(from_str_detail::load_u64(digits))
+			&& from_str_detail::is_eight_digits(from_str_detail::load_u64(digits + 8));
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_fixed
+// -----------------------------------------------------------------------------
+	/*
+		Parses a fixed format field into the value scaled by 10^FractionDigits.
+		Values never overflow, so only invalid_argument is reported.
+		out is untouched unless from_string_errc::ok is returned.
+	*/
+	template <std::size_t IntegerDigits, std::size_t FractionDigits>
+	traits::from_string_errc parse_fixed(std::string_view str, std::int64_t& out) noexcept
+	{
+		char digits[16];
+		bool negative = false;
+		if (!from_str_detail::stage_fixed<IntegerDigits, FractionDigits>(str, digits, negative)) {
+			return traits::from_string_errc::invalid_argument;
+		}
+		const auto value = static_cast<std::int64_t>(from_str_detail::parse_sixteen_digits(digits));
+		out = negative ? -value : value;
+		return traits::from_string_errc::ok;
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_fixed_batch
+// -----------------------------------------------------------------------------
+	/*
+		Columnar version of parse_fixed. Fields are staged in pairs
+		and their digits are converted two fields at a time.
+		The output type must be constructible by T::from_scaled(std::int64_t).
+	*/
+	template <std::size_t IntegerDigits, std::size_t FractionDigits, typename T>
+	std::size_t parse_fixed_batch(span<const std::string_view> strs, span<T> out, util::bitmap& valid) noexcept
+	{
+		using word_type = util::bitmap::word_type;
+		constexpr std::size_t word_bits = util::bitmap::word_bits;
+
+		const std::size_t size = strs.size();
+		for (std::size_t head = 0; head < size; head += word_bits) {
+			const std::size_t tail = size - head < word_bits ? size : head + word_bits;
+			word_type word = 0;
+
+			std::size_t i = head;
+			for (; i + 1 < tail; i += 2) {
+				char digits[2][16];
+				bool negative[2] = {};
+				const bool ok0 = from_str_detail::stage_fixed<IntegerDigits, FractionDigits>(strs[i], digits[0], negative[0]);
+				const bool ok1 = from_str_detail::stage_fixed<IntegerDigits, FractionDigits>(strs[i + 1], digits[1], negative[1]);
+
+				std::uint64_t value[2];
+				from_str_detail::parse_sixteen_digits_x2(
+					ok0 ? digits[0] : "0000000000000000", ok1 ? digits[1] : "0000000000000000", value[0], value[1]);
+				if (ok0) {
+					out[i] = T::from_scaled(negative[0] ? -static_cast<std::int64_t>(value[0]) : static_cast<std::int64_t>(value[0]));
+				}
+				if (ok1) {
+					out[i + 1] = T::from_scaled(negative[1] ? -static_cast<std::int64_t>(value[1]) : static_cast<std::int64_t>(value[1]));
+				}
+				word |= (word_type(ok0) | (word_type(ok1) << 1)) << (i - head);
+			}
+			for (; i < tail; ++i) {
+				std::int64_t value = 0;
+				const bool ok = from_str_detail::parse_fixed<IntegerDigits, FractionDigits>(strs[i], value) == traits::from_string_errc::ok;
+				if (ok) {
+					out[i] = T::from_scaled(value);
+				}
+				word |= word_type(ok) << (i - head);
+			}
+
+			valid.set_word(head / word_bits, word);
+		}
+		return valid.count();
+	}
+
+// -----------------------------------------------------------------------------
+//  scaled_to_float
+// -----------------------------------------------------------------------------
+	/*
+		Correctly rounded value of scaled / 10^fraction_digits.
+		Clinger's fast path covers up to 2^53, and the rest is rounded by Eisel-Lemire,
+		which is always exact for mantissas of at most 19 digits.
+	*/
+	template <typename T>
+	T scaled_to_float(std::int64_t scaled, std::size_t fraction_digits) noexcept
+	{
+		decimal_number d;
+		d.negative = scaled < 0;
+		d.mantissa = d.negative ? 0u - static_cast<std::uint64_t>(scaled) : static_cast<std::uint64_t>(scaled);
+		d.exponent = -static_cast<std::int64_t>(fraction_digits);
+		if (from_str_detail::fast_path_appliable<T>(d)) {
+			return from_str_detail::fast_path_float<T>(d);
+		}
+		return from_str_detail::to_float<T>(from_str_detail::eisel_lemire<T>(d.exponent, d.mantissa), d.negative);
+	}
+
+// -----------------------------------------------------------------------------
+//  scaled_to_string
+// -----------------------------------------------------------------------------
+	inline std::string scaled_to_string(std::int64_t scaled, std::size_t fraction_digits)
+	{
+		const bool negative = scaled < 0;
+		std::uint64_t magnitude = negative ? 0u - static_cast<std::uint64_t>(scaled) : static_cast<std::uint64_t>(scaled);
+
+		char buffer[32];
+		char* first = buffer + sizeof(buffer);
+		std::size_t count = 0;
+		do {
+			*--first = static_cast<char>('0' + magnitude % 10);
+			magnitude /= 10;
+			if (++count == fraction_digits) {
+				*--first = '.';
+			}
+		} while (magnitude != 0 || count <= fraction_digits);
+		if (negative) {
+			*--first = '-';
+		}
+		return std::string(first, buffer + sizeof(buffer));
+	}
+
+}} // namespace qsb::from_str_detail
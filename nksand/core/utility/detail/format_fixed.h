@@ -0,0 +1,177 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "format_integer.h"
+#include "parse_digits.h"
+
+namespace qsb { namespace to_str_detail {
+// -----------------------------------------------------------------------------
+//  write_sixteen_digits
+// -----------------------------------------------------------------------------
+	/*
+		Writes value < 10^16 as 16 ascii digits with leading zeros.
+		With SSE2, both halves of 8 digits are divided into single digits
+		by multiplications of 16bit lanes, and stored at once.
+		(W. Mula, "SSE: conversion integers to decimal representation")
+	*/
+#if defined(QSB_SIMD_SSE2)
+	// [a, b, c, d, e, f, g, h] in 16bit lanes for abcdefgh < 10^8
+	inline __m128i split_eight_digits(std::uint32_t value) noexcept
+	{
+		const __m128i abcdefgh = _mm_cvtsi32_si128(static_cast<int>(value));
+		const __m128i abcd = _mm_srli_epi64(_mm_mul_epu32(abcdefgh, _mm_set1_epi32(static_cast<int>(0xD1B71759u))), 45);
+		const __m128i efgh = _mm_sub_epi32(abcdefgh, _mm_mul_epu32(abcd, _mm_set1_epi32(10000)));
+
+		// [abcd * 4, ... (x4), efgh * 4, ... (x4)]
+		const __m128i v1 = _mm_slli_epi64(_mm_unpacklo_epi16(abcd, efgh), 2);
+		const __m128i v2 = _mm_unpacklo_epi32(_mm_unpacklo_epi16(v1, v1), _mm_unpacklo_epi16(v1, v1));
+
+		// [a, ab, abc, abcd, e, ef, efg, efgh]
+		const __m128i v3 = _mm_mulhi_epu16(v2, _mm_setr_epi16(8389, 5243, 13108, -32768, 8389, 5243, 13108, -32768));
+		const __m128i v4 = _mm_mulhi_epu16(v3, _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, -32768, 1 << 7, 1 << 11, 1 << 13, -32768));
+
+		// [a, ab, abc, abcd, ...] - [0, a0, ab0, abc0, ...]
+		const __m128i v5 = _mm_slli_epi64(_mm_mullo_epi16(v4, _mm_set1_epi16(10)), 16);
+		return _mm_sub_epi16(v4, v5);
+	}
+
+	inline void write_sixteen_digits(char* out, std::uint64_t value) noexcept
+	{
+		const __m128i hi = to_str_detail::split_eight_digits(static_cast<std::uint32_t>(value / 100000000u));
+		const __m128i lo = to_str_detail::split_eight_digits(static_cast<std::uint32_t>(value % 100000000u));
+		const __m128i digits = _mm_add_epi8(_mm_packus_epi16(hi, lo), _mm_set1_epi8('0'));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), digits);
+	}
+#else
+	inline void write_sixteen_digits(char* out, std::uint64_t value) noexcept
+	{
+		for (int i = 15; i >= 0; --i) {
+			out[i] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		}
+	}
+#endif
+
+// -----------------------------------------------------------------------------
+//  scale_fixed
+// -----------------------------------------------------------------------------
+	/*
+		Computes round(|d| * 10^prec) to nearest even of the exact binary value,
+		which is the rounding of printf("%.*f") and std::to_chars.
+		d = m * 2^e is multiplied by 10^prec in 128bit, and shifted right by -e.
+		Returns false if d is not finite, prec is not in [0, 19],
+		or the result does not fit in 64 bits.
+	*/
+	inline bool scale_fixed(double d, int prec, std::uint64_t& out) noexcept
+	{
+		if (prec < 0 || prec > 19) {
+			return false;
+		}
+		std::uint64_t bits;
+		std::memcpy(&bits, &d, sizeof(bits));
+		const auto biased = static_cast<int>((bits >> 52) & 0x7FF);
+		std::uint64_t m = bits & 0x000FFFFFFFFFFFFFull;
+		if (biased == 0x7FF) {
+			return false;
+		}
+		int e = -1074;
+		if (biased != 0) {
+			m |= 0x0010000000000000ull;
+			e = biased - 1075;
+		}
+
+		if (e >= 0) {
+			if (e > 11) {
+				return false;
+			}
+			const auto p = from_str_detail::full_multiplication(m << e, pow10_u64[prec]);
+			out = p.low;
+			return p.high == 0;
+		}
+
+		// p < 2^117, so results of shifts by more than 117 are rounded to 0
+		const auto p = from_str_detail::full_multiplication(m, pow10_u64[prec]);
+		const int shift = -e;
+		if (shift > 117) {
+			out = 0;
+			return true;
+		}
+
+		std::uint64_t q, rem_hi, rem_lo, half_hi, half_lo;
+		if (shift < 64) {
+			if ((p.high >> shift) != 0) {
+				return false;
+			}
+			q = (p.low >> shift) | (p.high << (64 - shift));
+			rem_hi = 0;
+			rem_lo = p.low & ((std::uint64_t(1) << shift) - 1);
+			half_hi = 0;
+			half_lo = std::uint64_t(1) << (shift - 1);
+		}
+		else {
+			const int high_shift = shift - 64;
+			q = p.high >> high_shift;
+			rem_hi = p.high & ((std::uint64_t(1) << high_shift) - 1);
+			rem_lo = p.low;
+			half_hi = high_shift == 0 ? 0 : std::uint64_t(1) << (high_shift - 1);
+			half_lo = high_shift == 0 ? std::uint64_t(1) << 63 : 0;
+		}
+
+		const bool above = rem_hi > half_hi || (rem_hi == half_hi && rem_lo > half_lo);
+		const bool tie = rem_hi == half_hi && rem_lo == half_lo;
+		if (above || (tie && (q & 1))) {
+			if (++q == 0) {
+				return false;
+			}
+		}
+		out = q;
+		return true;
+	}
+
+// -----------------------------------------------------------------------------
+//  format_fixed_fast
+// -----------------------------------------------------------------------------
+	/*
+		Writes d in "%.*f" format into out, which must have max_fixed_fast_size characters.
+		Returns nullptr if d is out of the range of scale_fixed.
+		All 20 digits of the scaled value are generated at once,
+		and the integer and fraction parts are copied with the decimal point.
+	*/
+	constexpr std::size_t max_fixed_fast_size = 24;
+
+	inline char* format_fixed_fast(char* out, double d, int prec) noexcept
+	{
+		std::uint64_t q = 0;
+		if (!to_str_detail::scale_fixed(d, prec, q)) {
+			return nullptr;
+		}
+
+		// 4 + 16 digits
+		char digits[20];
+		const std::uint64_t head = q / pow10_u64[16];
+		const std::uint64_t tail = q % pow10_u64[16];
+		std::memcpy(digits, digit_pairs.chars + 2 * (head / 100), 2);
+		std::memcpy(digits + 2, digit_pairs.chars + 2 * (head % 100), 2);
+		to_str_detail::write_sixteen_digits(digits + 4, tail);
+
+		const int count = to_str_detail::count_digits(q);
+		const int total = count > prec ? count : prec + 1;
+		const auto integers = static_cast<std::size_t>(total - prec);
+		const auto fractions = static_cast<std::size_t>(prec);
+		const char* const first = digits + (20 - total);
+
+		*out = '-';
+		out += std::signbit(d) ? 1 : 0;
+		std::memcpy(out, first, integers);
+		out += integers;
+		if (fractions != 0) {
+			*out++ = '.';
+			std::memcpy(out, first + integers, fractions);
+			out += fractions;
+		}
+		return out;
+	}
+
+}} // namespace qsb::to_str_detail
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "bit.h"
+
+namespace qsb { namespace to_str_detail {
+// -----------------------------------------------------------------------------
+//  pow10_u64
+// -----------------------------------------------------------------------------
+	inline constexpr std::uint64_t pow10_u64[20] = {
+		1ull, 10ull, 100ull, 1000ull, 10000ull,
+		100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+		10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+		1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+	};
+
+// -----------------------------------------------------------------------------
+//  digit_pairs
+// -----------------------------------------------------------------------------
+	// "00", "01", ..., "99"
+	struct digit_pair_table {
+		char chars[200];
+	};
+
+	constexpr digit_pair_table make_digit_pairs() noexcept
+	{
+		digit_pair_table table {};
+		for (int i = 0; i < 100; ++i) {
+			table.chars[2 * i] = static_cast<char>('0' + i / 10);
+			table.chars[2 * i + 1] = static_cast<char>('0' + i % 10);
+		}
+		return table;
+	}
+
+	inline constexpr digit_pair_table digit_pairs = to_str_detail::make_digit_pairs();
+
+// -----------------------------------------------------------------------------
+//  count_digits
+// -----------------------------------------------------------------------------
+	/*
+		Number of decimal digits of value, 1 for 0.
+		log10(2) ~ 1233 / 4096 gives the count from the bit width up to one,
+		which is corrected by one comparison with a power of 10.
+	*/
+	inline int count_digits(std::uint64_t value) noexcept
+	{
+		// powers of 10 are even, so value | 1 has the same count
+		value |= 1;
+		const int t = (bit_detail::bit_width(value) * 1233) >> 12;
+		return t + 1 - (value < pow10_u64[t] ? 1 : 0);
+	}
+
+// -----------------------------------------------------------------------------
+//  write_digits
+// -----------------------------------------------------------------------------
+	// writes exactly count digits of value ending at out + count, two digits per step
+	inline void write_digits(char* out, std::uint64_t value, int count) noexcept
+	{
+		char* p = out + count;
+		while (value >= 100) {
+			p -= 2;
+			std::memcpy(p, digit_pairs.chars + 2 * (value % 100), 2);
+			value /= 100;
+		}
+		if (value >= 10) {
+			p -= 2;
+			std::memcpy(p, digit_pairs.chars + 2 * value, 2);
+		}
+		else {
+			*--p = static_cast<char>('0' + value);
+		}
+	}
+
+// -----------------------------------------------------------------------------
+//  format_integer
+// -----------------------------------------------------------------------------
+	/*
+		Writes value in decimal into [first, last), and returns the end of the written characters,
+		or nullptr if the range is too short.
+		The length is counted first, so digits are written in place from the end.
+	*/
+	constexpr std::size_t max_integer_size = 20;
+
+	template <typename T>
+	char* format_integer(char* first, char* last, T value) noexcept
+	{
+		static_assert(std::is_integral_v<T>, "integral type is required.");
+		using unsigned_type = std::make_unsigned_t<std::conditional_t<std::is_same_v<T, bool>, unsigned char, T>>;
+
+		const bool negative = value < T(0);
+		const auto magnitude = static_cast<std::uint64_t>(static_cast<unsigned_type>(negative
+			? unsigned_type(0) - static_cast<unsigned_type>(value)
+			: static_cast<unsigned_type>(value)));
+		const int count = to_str_detail::count_digits(magnitude);
+		const auto size = static_cast<std::size_t>(count) + (negative ? 1 : 0);
+		if (static_cast<std::size_t>(last - first) < size) {
+			return nullptr;
+		}
+		*first = '-';
+		to_str_detail::write_digits(first + (negative ? 1 : 0), magnitude, count);
+		return first + size;
+	}
+
+}} // namespace qsb::to_str_detail
@@ -1,9 +1,13 @@
 #pragma once
-#include <cerrno>
 #include <type_traits>
+#include <atomic>
 #include <cstdint>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include "../optional.h"
+#include "parse_integer.h"
+#include "parse_float.h"
 
 namespace qsb { namespace from_str_detail {
 // -----------------------------------------------------------------------------
@@ -47,107 +51,234 @@ namespace qsb { namespace from_str_detail {
 	using get_tag = decltype(get_tag_impl(member_function_tag{}, std::declval<T>()));
 
 // -----------------------------------------------------------------------------
-//  strtox
+//	tags for dispatch of try_apply
+// -----------------------------------------------------------------------------
+	struct try_short_member_function_tag : not_defined_tag {};
+	struct try_member_function_tag : try_short_member_function_tag {};
+
+// -----------------------------------------------------------------------------
+//  get_try_tag
 // -----------------------------------------------------------------------------
 	template <typename T>
-	T strtox(const char* str, char** e, int base = 10);
+	constexpr auto get_try_tag_impl(try_short_member_function_tag, T&&) -> std::enable_if_t<
+		std::is_same_v<decltype(T::try_from_str(std::declval<const char*>(), std::declval<T&>())), bool>,
+		try_short_member_function_tag
+	>;
 
-	template <>
-	short strtox<short>(const char* str, char** e, int base)
-	{
-		return static_cast<short>(std::strtol(str, e, base));
-	}
+	template <typename T>
+	constexpr auto get_try_tag_impl(try_member_function_tag, T&&) -> std::enable_if_t<
+		std::is_same_v<decltype(T::try_from_string(std::declval<const char*>(), std::declval<T&>())), bool>,
+		try_member_function_tag
+	>;
 
-	template <>
-	unsigned short strtox<unsigned short>(const char* str, char** e, int base)
-	{
-		return static_cast<unsigned short>(std::strtoul(str, e, base));
-	}
+	template <typename T>
+	using get_try_tag = decltype(get_try_tag_impl(try_member_function_tag{}, std::declval<T>()));
 
-	template <>
-	int strtox<int>(const char* str, char** e, int base)
+// -----------------------------------------------------------------------------
+//  trait_appliable
+// -----------------------------------------------------------------------------
+	auto trait_appliable_impl(...) -> std::false_type;
+
+	template <typename T, typename ...Args>
+	auto trait_appliable_impl(T, Args&&...) -> decltype(T::apply(std::declval<Args>()...), std::true_type{});
+
+	template <typename T, typename ...Args>
+	using trait_appliable = decltype(trait_appliable_impl(std::declval<T>(), std::declval<Args>()...));
+
+// -----------------------------------------------------------------------------
+//  trait_try_appliable
+// -----------------------------------------------------------------------------
+	auto trait_try_appliable_impl(...) -> std::false_type;
+
+	template <typename Trait, typename T, typename Str>
+	auto trait_try_appliable_impl(Trait, T*, Str&&) -> decltype(
+		std::enable_if_t<std::is_same_v<
+			decltype(Trait::try_apply(std::declval<Str>(), std::declval<T&>())), traits::from_string_errc
+		>>(), std::true_type{});
+
+	template <typename Trait, typename T, typename Str>
+	using trait_try_appliable = decltype(
+		trait_try_appliable_impl(std::declval<Trait>(), std::declval<T*>(), std::declval<Str>()));
+
+// -----------------------------------------------------------------------------
+//  string_appliable
+// -----------------------------------------------------------------------------
+	/*
+		A trait is appliable to strings if it accepts either of const char* or std::string_view.
+		The missing one is adapted by apply_trait and try_apply_trait.
+	*/
+	template <typename Trait>
+	using string_appliable = std::bool_constant<
+		trait_appliable<Trait, const char*>::value ||
+		trait_appliable<Trait, std::string_view>::value
+	>;
+
+// -----------------------------------------------------------------------------
+//  with_c_str
+// -----------------------------------------------------------------------------
+	/*
+		Calls f with a null terminated copy of str.
+		Short strings, such as numbers, are copied into a stack buffer without allocation.
+	*/
+	template <typename F>
+	decltype(auto) with_c_str(std::string_view str, F&& f)
 	{
-		return static_cast<int>(std::strtol(str, e, base));
+		constexpr std::size_t buffer_size = 128;
+		if (str.size() < buffer_size) {
+			char buffer[buffer_size];
+			buffer[str.copy(buffer, str.size())] = '\0';
+			return std::forward<F>(f)(static_cast<const char*>(buffer));
+		}
+		const std::string copied(str);
+		return std::forward<F>(f)(copied.c_str());
 	}
 
-	template <>
-	unsigned strtox<unsigned>(const char* str, char** e, int base)
+// -----------------------------------------------------------------------------
+//	tags for dispatch of apply_trait and try_apply_trait
+// -----------------------------------------------------------------------------
+	struct catch_adapter_tag {};
+	struct c_str_adapter_tag : catch_adapter_tag {};
+	struct direct_adapter_tag : c_str_adapter_tag {};
+
+// -----------------------------------------------------------------------------
+//  apply_trait
+// -----------------------------------------------------------------------------
+	/*
+		Invokes Trait::apply. If Trait does not accept std::string_view,
+		it is invoked with a null terminated copy.
+	*/
+	template <typename Trait, typename Str>
+	constexpr auto apply_trait_impl(Str str, direct_adapter_tag) -> decltype(Trait::apply(str))
 	{
-		return static_cast<unsigned>(std::strtoul(str, e, base));
+		return Trait::apply(str);
 	}
 
-	template <>
-	long strtox<long>(const char* str, char** e, int base)
+	template <typename Trait>
+	auto apply_trait_impl(std::string_view str, c_str_adapter_tag)
+		-> decltype(Trait::apply(std::declval<const char*>()))
 	{
-		return std::strtol(str, e, base);
+		return with_c_str(str, [](const char* s) { return Trait::apply(s); });
 	}
 
-	template <>
-	unsigned long strtox<unsigned long>(const char* str, char** e, int base)
+	template <typename Trait, typename Str>
+	constexpr decltype(auto) apply_trait(Str str)
 	{
-		return std::strtoul(str, e, base);
+		return from_str_detail::apply_trait_impl<Trait>(str, direct_adapter_tag{});
 	}
 
-	template <>
-	long long strtox<long long>(const char* str, char** e, int base)
+// -----------------------------------------------------------------------------
+//  try_apply_trait
+// -----------------------------------------------------------------------------
+	/*
+		Invokes Trait::try_apply if it is provided.
+		Otherwise, Trait::apply is invoked in try-catch as a fallback.
+	*/
+	template <typename Trait, typename T, typename Str>
+	constexpr auto try_apply_trait_impl(Str str, T& out, direct_adapter_tag) -> std::enable_if_t<
+		trait_try_appliable<Trait, T, Str>::value,
+		traits::from_string_errc
+	>
 	{
-		return std::strtoll(str, e, base);
+		return Trait::try_apply(str, out);
 	}
 
-	template <>
-	unsigned long long strtox<unsigned long long>(const char* str, char** e, int base)
+	template <typename Trait, typename T>
+	auto try_apply_trait_impl(std::string_view str, T& out, c_str_adapter_tag) -> std::enable_if_t<
+		trait_try_appliable<Trait, T, const char*>::value,
+		traits::from_string_errc
+	>
 	{
-		return std::strtoull(str, e, base);
+		return with_c_str(str, [&out](const char* s) { return Trait::try_apply(s, out); });
 	}
 
-	template <>
-	float strtox<float>(const char* str, char** e, int)
+	template <typename Trait, typename T, typename Str>
+	traits::from_string_errc try_apply_trait_impl(Str str, T& out, catch_adapter_tag) noexcept
 	{
-		return std::strtof(str, e);
+		try {
+			out = from_str_detail::apply_trait<Trait>(str);
+			return traits::from_string_errc::ok;
+		}
+		catch (const std::out_of_range&) {
+			return traits::from_string_errc::out_of_range;
+		}
+		catch (...) {
+			return traits::from_string_errc::invalid_argument;
+		}
 	}
 
-	template <>
-	double strtox<double>(const char* str, char** e, int)
+	template <typename Trait, typename T, typename Str>
+	constexpr traits::from_string_errc try_apply_trait(Str str, T& out)
 	{
-		return std::strtod(str, e);
+		return from_str_detail::try_apply_trait_impl<Trait>(str, out, direct_adapter_tag{});
 	}
 
-	template <>
-	long double strtox<long double>(const char* str, char** e, int)
+// -----------------------------------------------------------------------------
+//  throw_if_failed
+// -----------------------------------------------------------------------------
+	constexpr void throw_if_failed(traits::from_string_errc ec)
 	{
-		return std::strtold(str, e);
+		switch (ec) {
+		case traits::from_string_errc::ok:
+			return;
+		case traits::from_string_errc::out_of_range:
+			throw std::invalid_argument("strtol argument out of range");
+		default:
+			throw std::invalid_argument("invalid strtol argument");
+		}
 	}
 
 // -----------------------------------------------------------------------------
-//  trait_appliable
+//  parse_number
 // -----------------------------------------------------------------------------
-	auto trait_appliable_impl(...) -> std::false_type;
-
-	template <typename T, typename ...Args>
-	auto trait_appliable_impl(T, Args&&...) -> decltype(T::apply(std::declval<Args>()...), std::true_type{});
+	template <typename T>
+	constexpr auto parse_number(std::string_view str, T& out) noexcept -> std::enable_if_t<
+		std::is_integral_v<T>,
+		traits::from_string_errc
+	>
+	{
+		return from_str_detail::parse_integer(str, out);
+	}
 
-	template <typename T, typename ...Args>
-	using trait_appliable = decltype(trait_appliable_impl(std::declval<T>(), std::declval<Args>()...));
+	template <typename T>
+	constexpr auto parse_number(std::string_view str, T& out) noexcept -> std::enable_if_t<
+		std::is_floating_point_v<T>,
+		traits::from_string_errc
+	>
+	{
+		return from_str_detail::parse_float(str, out);
+	}
 
 // -----------------------------------------------------------------------------
 //  from_string_to_number_impl
 // -----------------------------------------------------------------------------
+	// constexpr, so that number literals can be converted at compile time
 	template <typename T>
 	struct from_string_to_number_impl {
-		static T apply(const char* str)
+	private:
+		using this_type = from_string_to_number_impl;
+
+	public:
+		static constexpr traits::from_string_errc try_apply(const char* str, T& out) noexcept
 		{
-		    int& errno_ref = errno;
-			char* eptr {};
-			errno_ref = 0;
-			const T result = strtox<T>(str, &eptr);
+			return from_str_detail::parse_number(std::string_view(str), out);
+		}
 
-			if (str == eptr) {
-				throw std::invalid_argument("invalid strtol argument");
-			}
+		static constexpr traits::from_string_errc try_apply(std::string_view str, T& out) noexcept
+		{
+			return from_str_detail::parse_number(str, out);
+		}
 
-			if (errno_ref == ERANGE) {
-				throw std::invalid_argument("strtol argument out of range");
-			}
+		static constexpr T apply(const char* str)
+		{
+			T result {};
+			throw_if_failed(this_type::try_apply(str, result));
+			return result;
+		}
+
+		static constexpr T apply(std::string_view str)
+		{
+			T result {};
+			throw_if_failed(this_type::try_apply(str, result));
 			return result;
 		}
 	};
@@ -164,6 +295,120 @@ namespace qsb { namespace from_str_detail {
 	template <typename T>
 	using is_optional = is_optional_impl<std::remove_cv_t<std::remove_reference_t<T>>>;
 
+// -----------------------------------------------------------------------------
+//  conversion_cache
+// -----------------------------------------------------------------------------
+	/*
+		Results of conversions of a string, one entry per requested type.
+
+		Entries form a singly linked list which only grows while the cache is shared.
+		A lookup is an acquire load of the head and a walk over the entries,
+		and a new entry is published by compare-exchange of the head.
+		So concurrent lookups never lock, and once an entry is visible it is never changed.
+		When two threads convert the same type at once, the loser discards its entry
+		and uses the published one, so every thread observes the same result.
+
+		Entries are keyed by the address of a static member instantiated per type.
+	*/
+	template <typename U>
+	struct conversion_cache_key {
+		static constexpr char value = 0;
+	};
+
+	struct conversion_cache_entry_base {
+		const void* key;
+		conversion_cache_entry_base* next;
+
+		explicit conversion_cache_entry_base(const void* k) noexcept : key(k), next(nullptr) {}
+		virtual ~conversion_cache_entry_base() = default;
+	};
+
+	template <typename U>
+	struct conversion_cache_entry : conversion_cache_entry_base {
+		traits::from_string_errc ec;
+		optional<U> value;
+
+		conversion_cache_entry(traits::from_string_errc e, optional<U>&& v)
+			: conversion_cache_entry_base(&conversion_cache_key<U>::value), ec(e), value(std::move(v))
+		{
+		}
+	};
+
+	class conversion_cache {
+	private:
+		using this_type = conversion_cache;
+
+	public:
+		conversion_cache() noexcept = default;
+		conversion_cache(const this_type&) = delete;
+		this_type& operator =(const this_type&) = delete;
+
+		// not thread safe. other is left empty
+		conversion_cache(this_type&& other) noexcept
+			: head_(other.head_.exchange(nullptr, std::memory_order_acq_rel))
+		{
+		}
+
+		~conversion_cache()
+		{
+			this->clear();
+		}
+
+		/*
+			Returns the entry of U. If there is none, convert(optional<U>&) is called
+			to make it. convert stores the value and returns the error code.
+		*/
+		template <typename U, typename F>
+		const conversion_cache_entry<U>& get_or_convert(F&& convert) const
+		{
+			conversion_cache_entry_base* head = head_.load(std::memory_order_acquire);
+			if (const auto found = this_type::find<U>(head, nullptr)) {
+				return *found;
+			}
+
+			optional<U> value(nullopt);
+			const traits::from_string_errc ec = std::forward<F>(convert)(value);
+			auto* created = new conversion_cache_entry<U>(ec, std::move(value));
+			created->next = head;
+			while (!head_.compare_exchange_weak(created->next, created, std::memory_order_acq_rel, std::memory_order_acquire)) {
+				// entries pushed meanwhile may contain U
+				if (const auto found = this_type::find<U>(created->next, head)) {
+					delete created;
+					return *found;
+				}
+				head = created->next;
+			}
+			return *created;
+		}
+
+		// not thread safe
+		void clear() noexcept
+		{
+			conversion_cache_entry_base* entry = head_.exchange(nullptr, std::memory_order_acquire);
+			while (entry) {
+				conversion_cache_entry_base* next = entry->next;
+				delete entry;
+				entry = next;
+			}
+		}
+
+	private:
+		template <typename U>
+		static const conversion_cache_entry<U>* find(conversion_cache_entry_base* first, conversion_cache_entry_base* last) noexcept
+		{
+			for (; first != last; first = first->next) {
+				if (first->key == &conversion_cache_key<U>::value) {
+					return static_cast<const conversion_cache_entry<U>*>(first);
+				}
+			}
+			return nullptr;
+		}
+
+	private:
+		mutable std::atomic<conversion_cache_entry_base*> head_ { nullptr };
+
+	}; // class conversion_cache
+
 }} // namespace qsb::from_str_detail
 
 namespace qsb { namespace traits {
@@ -190,12 +435,40 @@ namespace qsb { namespace traits {
 			return T::from_string(str);
 		}
 
+		static from_string_errc try_apply(const char* str, T& out, from_str_detail::try_short_member_function_tag)
+		{
+			return T::try_from_str(str, out) ? from_string_errc::ok : from_string_errc::invalid_argument;
+		}
+
+		static from_string_errc try_apply(const char* str, T& out, from_str_detail::try_member_function_tag)
+		{
+			return T::try_from_string(str, out) ? from_string_errc::ok : from_string_errc::invalid_argument;
+		}
+
 	public:
-		template <typename Dummy = void>
+		template <typename U = T>
 		static auto apply(const char* str) -> std::enable_if_t<
-			!std::is_same_v<from_str_detail::get_tag<T>, from_str_detail::not_defined_tag>, T>
+			!std::is_same_v<from_str_detail::get_tag<U>, from_str_detail::not_defined_tag>, T>
+		{
+			return this_type::apply(str, from_str_detail::get_tag<U>{});
+		}
+
+		// types directly constructible from a view, such as std::string, need no null terminated copy
+		template <typename U = T, std::enable_if_t<
+			std::is_same_v<from_str_detail::get_tag<U>, from_str_detail::convertible_tag> &&
+			std::is_constructible_v<U, std::string_view>,
+		std::nullptr_t> = nullptr>
+		static T apply(std::string_view str)
+		{
+			return static_cast<T>(str);
+		}
+
+		template <typename U = T, std::enable_if_t<
+			!std::is_same_v<from_str_detail::get_try_tag<U>, from_str_detail::not_defined_tag>,
+		std::nullptr_t> = nullptr>
+		static from_string_errc try_apply(const char* str, T& out)
 		{
-			return this_type::apply(str, from_str_detail::get_tag<T>{});
+			return this_type::try_apply(str, out, from_str_detail::get_try_tag<U>{});
 		}
 	};
 
@@ -227,30 +500,73 @@ namespace qsb { namespace traits {
 	struct from_string_trait<std::int8_t, std::enable_if_t<
 		std::is_same_v<std::int8_t, unsigned char> ||
 		std::is_same_v<std::int8_t, signed char>>
-	> {
-		static std::int8_t apply(const char* str)
-		{
-			return static_cast<std::int8_t>(
-				from_str_detail::from_string_to_number_impl<long>::apply(str));
-		}
-	};
+	> : from_str_detail::from_string_to_number_impl<std::int8_t> {};
 
 // -----------------------------------------------------------------------------
 //  from_string_trait<optional>
 // -----------------------------------------------------------------------------
+	/*
+		Never fails. Malformed inputs are converted into nullopt.
+		If from_string_trait<T> provides try_apply and T is default constructible,
+		conversion is done without throw/catch.
+	*/
 	template <typename T>
 	struct from_string_trait<optional<T>, std::enable_if_t<
-		from_str_detail::trait_appliable<from_string_trait<T>, const char*>::value
+		from_str_detail::string_appliable<from_string_trait<T>>::value
 	>> {
-		static optional<T> apply(const char* str)
+	private:
+		using this_type = from_string_trait;
+		using value_trait = from_string_trait<T>;
+
+		template <typename Str>
+		static constexpr bool is_try_appliable
+			= std::is_default_constructible_v<T> && (
+				from_str_detail::trait_try_appliable<value_trait, T, Str>::value ||
+				from_str_detail::trait_try_appliable<value_trait, T, const char*>::value);
+
+		template <typename Str>
+		static constexpr optional<T> apply(Str str, std::true_type)
+		{
+			T value {};
+			if (from_str_detail::try_apply_trait<value_trait>(str, value) != from_string_errc::ok) {
+				return optional<T>(nullopt);
+			}
+			return optional<T>(std::move(value));
+		}
+
+		template <typename Str>
+		static optional<T> apply(Str str, std::false_type) noexcept
 		{
 			try {
-				return optional<T>(from_string_trait<T>::apply(str));
+				return optional<T>(from_str_detail::apply_trait<value_trait>(str));
 			}
 			catch (...) {
 				return optional<T>(nullopt);
 			}
 		}
+
+	public:
+		static constexpr optional<T> apply(const char* str)
+		{
+			return this_type::apply(str, std::bool_constant<is_try_appliable<const char*>>{});
+		}
+
+		static constexpr optional<T> apply(std::string_view str)
+		{
+			return this_type::apply(str, std::bool_constant<is_try_appliable<std::string_view>>{});
+		}
+
+		static constexpr from_string_errc try_apply(const char* str, optional<T>& out)
+		{
+			out = this_type::apply(str);
+			return from_string_errc::ok;
+		}
+
+		static constexpr from_string_errc try_apply(std::string_view str, optional<T>& out)
+		{
+			out = this_type::apply(str);
+			return from_string_errc::ok;
+		}
 	};
 
 }} // namespace qsb::traits
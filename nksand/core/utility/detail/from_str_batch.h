@@ -0,0 +1,234 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include "../../ranges.h"
+#include "../bitmap.h"
+#include "from_str.h"
+#include "parse_digits.h"
+
+namespace qsb { namespace from_str_detail {
+// -----------------------------------------------------------------------------
+//  staged_decimal
+// -----------------------------------------------------------------------------
+	/*
+		A plain decimal field
+			[+|-]digits[.digits]
+		of at most 16 characters, whose digits are right aligned in a '0' padded buffer
+		so that they are converted by a single 16 digits kernel.
+	*/
+	struct staged_decimal {
+		char digits[16];
+		int fraction_digits;
+		bool negative;
+		bool has_dot;
+	};
+
+// -----------------------------------------------------------------------------
+//  stage_decimal
+// -----------------------------------------------------------------------------
+	/*
+		Returns false for fields which are not plain decimals,
+		ex. with exponent, inf/nan, too long or malformed. They are left to the scalar parsers.
+	*/
+	inline bool stage_decimal(std::string_view str, staged_decimal& out) noexcept
+	{
+		const std::size_t size = str.size();
+		if (size == 0 || size > 16) {
+			return false;
+		}
+		char raw[16] = {};
+		std::memcpy(raw, str.data(), size);
+
+		const unsigned size_mask = (1u << size) - 1u;
+		const unsigned sign = (raw[0] == '-' || raw[0] == '+') ? 1u : 0u;
+		const char_class_masks masks = from_str_detail::classify_sixteen_chars(raw);
+		const unsigned dots = masks.dots & size_mask;
+		if (((masks.digits | dots | sign) & size_mask) != size_mask || (dots & (dots - 1u)) != 0) {
+			return false;
+		}
+
+		std::size_t dot = size;
+		if (dots != 0) {
+			for (dot = 0; ((dots >> dot) & 1u) == 0; ++dot) {}
+		}
+		const std::size_t integer_digits = dot - sign;
+		const std::size_t fraction_digits = dots != 0 ? size - dot - 1 : 0;
+		if (integer_digits + fraction_digits == 0) {
+			return false;
+		}
+
+		std::memset(out.digits, '0', sizeof(out.digits));
+		std::memcpy(out.digits + 16 - fraction_digits - integer_digits, raw + sign, integer_digits);
+		std::memcpy(out.digits + 16 - fraction_digits, raw + dot + 1, fraction_digits);
+		out.fraction_digits = static_cast<int>(fraction_digits);
+		out.negative = raw[0] == '-';
+		out.has_dot = dots != 0;
+		return true;
+	}
+
+// -----------------------------------------------------------------------------
+//  finish_staged
+// -----------------------------------------------------------------------------
+	/*
+		Builds a value from a staged decimal and its converted digits.
+		Returns false if the value needs the scalar parser,
+		ex. out of the exact range of Clinger's fast path or of the integer type.
+		Results are identical to parse_number.
+	*/
+	template <typename T>
+	auto finish_staged(const staged_decimal& s, std::uint64_t mantissa, T& out) noexcept -> std::enable_if_t<
+		std::is_floating_point_v<T>,
+		bool
+	>
+	{
+		decimal_number d;
+		d.mantissa = mantissa;
+		d.exponent = -s.fraction_digits;
+		d.negative = s.negative;
+		if (!from_str_detail::fast_path_appliable<T>(d)) {
+			return false;
+		}
+		out = from_str_detail::fast_path_float<T>(d);
+		return true;
+	}
+
+	template <typename T>
+	auto finish_staged(const staged_decimal& s, std::uint64_t mantissa, T& out) noexcept -> std::enable_if_t<
+		std::is_integral_v<T>,
+		bool
+	>
+	{
+		using unsigned_type = std::make_unsigned_t<T>;
+		constexpr auto max_magnitude = static_cast<unsigned_type>(std::numeric_limits<T>::max());
+		if (s.has_dot || (s.negative && std::is_unsigned_v<T>)) {
+			return false;
+		}
+		if (mantissa > std::uint64_t(max_magnitude) + (s.negative ? 1u : 0u)) {
+			return false;
+		}
+		const auto value = static_cast<unsigned_type>(mantissa);
+		out = s.negative ? static_cast<T>(static_cast<unsigned_type>(0u - value)) : static_cast<T>(value);
+		return true;
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_number_batch
+// -----------------------------------------------------------------------------
+	/*
+		Columnar kernel of from_string_trait<number>::try_apply_batch.
+
+		Plain decimal fields are staged and their digits are converted two fields at a time
+		(in two lanes of an AVX2 register, by SSE4.1 or by SWAR depending on the target).
+		Other fields and values out of the fast range are passed to parse_number,
+		so the results are identical to the scalar try_apply.
+		Validity bits are accumulated into a word and stored once per 64 fields.
+	*/
+	template <typename T>
+	std::size_t parse_number_batch(span<const std::string_view> strs, span<T> out, util::bitmap& valid) noexcept
+	{
+		using word_type = util::bitmap::word_type;
+		constexpr std::size_t word_bits = util::bitmap::word_bits;
+
+		const std::size_t size = strs.size();
+		for (std::size_t head = 0; head < size; head += word_bits) {
+			const std::size_t tail = size - head < word_bits ? size : head + word_bits;
+			word_type word = 0;
+
+			std::size_t i = head;
+			for (; i + 1 < tail; i += 2) {
+				staged_decimal s[2];
+				const bool staged0 = from_str_detail::stage_decimal(strs[i], s[0]);
+				const bool staged1 = from_str_detail::stage_decimal(strs[i + 1], s[1]);
+
+				std::uint64_t mantissa[2] = {};
+				if (staged0 && staged1) {
+					from_str_detail::parse_sixteen_digits_x2(s[0].digits, s[1].digits, mantissa[0], mantissa[1]);
+				}
+				else if (staged0) {
+					mantissa[0] = from_str_detail::parse_sixteen_digits(s[0].digits);
+				}
+				else if (staged1) {
+					mantissa[1] = from_str_detail::parse_sixteen_digits(s[1].digits);
+				}
+
+				const bool staged[2] = { staged0, staged1 };
+				for (std::size_t k = 0; k < 2; ++k) {
+					const bool ok = (staged[k] && from_str_detail::finish_staged(s[k], mantissa[k], out[i + k]))
+						|| from_str_detail::parse_number(strs[i + k], out[i + k]) == traits::from_string_errc::ok;
+					word |= word_type(ok) << (i + k - head);
+				}
+			}
+			for (; i < tail; ++i) {
+				const bool ok = from_str_detail::parse_number(strs[i], out[i]) == traits::from_string_errc::ok;
+				word |= word_type(ok) << (i - head);
+			}
+
+			valid.set_word(head / word_bits, word);
+		}
+		return valid.count();
+	}
+
+	inline std::size_t parse_number_batch(span<const std::string_view> strs, span<long double> out, util::bitmap& valid) noexcept
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < strs.size(); ++i) {
+			const bool ok = from_str_detail::parse_number(strs[i], out[i]) == traits::from_string_errc::ok;
+			valid.set(i, ok);
+			count += ok ? 1 : 0;
+		}
+		return count;
+	}
+
+// -----------------------------------------------------------------------------
+//	tags for dispatch of try_apply_batch_trait
+// -----------------------------------------------------------------------------
+	struct loop_batch_tag {};
+	struct number_batch_tag : loop_batch_tag {};
+	struct member_batch_tag : number_batch_tag {};
+
+// -----------------------------------------------------------------------------
+//  try_apply_batch_trait
+// -----------------------------------------------------------------------------
+	/*
+		Invokes Trait::try_apply_batch if it is provided.
+		Otherwise, numbers are converted by parse_number_batch
+		and the others by try_apply_trait field by field.
+		valid must be sized to strs.size() with all bits reset.
+	*/
+	template <typename Trait, typename T>
+	auto try_apply_batch_trait_impl(span<const std::string_view> strs, span<T> out, util::bitmap& valid, member_batch_tag)
+		-> decltype(Trait::try_apply_batch(strs, out, valid))
+	{
+		return Trait::try_apply_batch(strs, out, valid);
+	}
+
+	template <typename Trait, typename T>
+	auto try_apply_batch_trait_impl(span<const std::string_view> strs, span<T> out, util::bitmap& valid, number_batch_tag)
+		-> std::enable_if_t<std::is_base_of_v<from_string_to_number_impl<T>, Trait>, std::size_t>
+	{
+		return from_str_detail::parse_number_batch(strs, out, valid);
+	}
+
+	template <typename Trait, typename T>
+	std::size_t try_apply_batch_trait_impl(span<const std::string_view> strs, span<T> out, util::bitmap& valid, loop_batch_tag)
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < strs.size(); ++i) {
+			if (from_str_detail::try_apply_trait<Trait>(strs[i], out[i]) == traits::from_string_errc::ok) {
+				valid.set(i);
+				++count;
+			}
+		}
+		return count;
+	}
+
+	template <typename Trait, typename T>
+	std::size_t try_apply_batch_trait(span<const std::string_view> strs, span<T> out, util::bitmap& valid)
+	{
+		return from_str_detail::try_apply_batch_trait_impl<Trait>(strs, out, valid, member_batch_tag{});
+	}
+
+}} // namespace qsb::from_str_detail
@@ -0,0 +1,200 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+//  instruction sets
+// -----------------------------------------------------------------------------
+/*
+	Vectorized digit kernels are enabled by the target instruction set of the compiler,
+	ex. /arch:AVX2 for MSVC and -mavx2 or -msse4.1 for gcc and clang.
+	SSE2 is a part of x64, so the kernels requiring only SSE2 are enabled by default there.
+	Define QSB_DISABLE_SIMD to force the portable SWAR (SIMD within a register) kernels.
+	All kernels assume a little endian target.
+*/
+#if !defined(QSB_DISABLE_SIMD)
+#	if defined(__AVX2__)
+#		define QSB_SIMD_AVX2 1
+#	endif
+#	if defined(__AVX2__) || defined(__AVX__) || defined(__SSE4_1__)
+#		define QSB_SIMD_SSE41 1
+#	endif
+#	if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define QSB_SIMD_SSE2 1
+#	endif
+#endif
+
+#if defined(QSB_SIMD_AVX2)
+#	include <immintrin.h>
+#elif defined(QSB_SIMD_SSE41)
+#	include <smmintrin.h>
+#elif defined(QSB_SIMD_SSE2)
+#	include <emmintrin.h>
+#endif
+
+namespace qsb { namespace from_str_detail {
+// -----------------------------------------------------------------------------
+//  uint128
+// -----------------------------------------------------------------------------
+	struct uint128 {
+		std::uint64_t low;
+		std::uint64_t high;
+	};
+
+	constexpr uint128 full_multiplication(std::uint64_t a, std::uint64_t b) noexcept
+	{
+#if defined(__SIZEOF_INT128__)
+		const auto r = static_cast<unsigned __int128>(a) * b;
+		return {static_cast<std::uint64_t>(r), static_cast<std::uint64_t>(r >> 64)};
+#else
+		const std::uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+		const std::uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+		const std::uint64_t lo_lo = a_lo * b_lo;
+		const std::uint64_t hi_lo = a_hi * b_lo;
+		const std::uint64_t lo_hi = a_lo * b_hi;
+		const std::uint64_t hi_hi = a_hi * b_hi;
+		const std::uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+		return {(cross << 32) | (lo_lo & 0xFFFFFFFFu), (hi_lo >> 32) + (cross >> 32) + hi_hi};
+#endif
+	}
+
+// -----------------------------------------------------------------------------
+//  load_u64
+// -----------------------------------------------------------------------------
+	inline std::uint64_t load_u64(const char* p) noexcept
+	{
+		std::uint64_t result;
+		std::memcpy(&result, p, sizeof(result));
+		return result;
+	}
+
+// -----------------------------------------------------------------------------
+//  is_eight_digits
+// -----------------------------------------------------------------------------
+	// true if all 8 bytes of the little endian word are in '0'..'9'
+	constexpr bool is_eight_digits(std::uint64_t word) noexcept
+	{
+		return ((word & 0xF0F0F0F0F0F0F0F0ull) |
+			(((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_eight_digits
+// -----------------------------------------------------------------------------
+	/*
+		Converts 8 ascii digits in a little endian word into a number with 3 multiplications.
+		The first character is the most significant digit.
+		The word must satisfy is_eight_digits.
+	*/
+	constexpr std::uint32_t parse_eight_digits(std::uint64_t word) noexcept
+	{
+		constexpr std::uint64_t mask = 0x000000FF000000FFull;
+		constexpr std::uint64_t mul1 = 0x000F424000000064ull;	// 100 + (1000000 << 32)
+		constexpr std::uint64_t mul2 = 0x0000271000000001ull;	// 1 + (10000 << 32)
+		word -= 0x3030303030303030ull;
+		word = (word * 10) + (word >> 8);						// pairs of digits
+		word = (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32;
+		return static_cast<std::uint32_t>(word);
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_sixteen_digits
+// -----------------------------------------------------------------------------
+	/*
+		Converts 16 ascii digits starting at p into a number.
+		All of 16 characters must be digits.
+	*/
+#if defined(QSB_SIMD_SSE41)
+	inline std::uint64_t parse_sixteen_digits(const char* p) noexcept
+	{
+		__m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		t = _mm_sub_epi8(t, _mm_set1_epi8('0'));
+		t = _mm_maddubs_epi16(t, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+		t = _mm_madd_epi16(t, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+		t = _mm_packus_epi32(t, t);
+		t = _mm_madd_epi16(t, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+		const auto hi = static_cast<std::uint32_t>(_mm_extract_epi32(t, 0));
+		const auto lo = static_cast<std::uint32_t>(_mm_extract_epi32(t, 1));
+		return std::uint64_t(hi) * 100000000u + lo;
+	}
+#else
+	inline std::uint64_t parse_sixteen_digits(const char* p) noexcept
+	{
+		return std::uint64_t(from_str_detail::parse_eight_digits(from_str_detail::load_u64(p))) * 100000000u
+			+ from_str_detail::parse_eight_digits(from_str_detail::load_u64(p + 8));
+	}
+#endif
+
+// -----------------------------------------------------------------------------
+//  parse_sixteen_digits_x2
+// -----------------------------------------------------------------------------
+	/*
+		Converts two runs of 16 ascii digits at once.
+		With AVX2, each run occupies one 128bit lane of a register.
+	*/
+#if defined(QSB_SIMD_AVX2)
+	inline void parse_sixteen_digits_x2(const char* p0, const char* p1, std::uint64_t& out0, std::uint64_t& out1) noexcept
+	{
+		__m256i t = _mm256_set_m128i(
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0)));
+		t = _mm256_sub_epi8(t, _mm256_set1_epi8('0'));
+		t = _mm256_maddubs_epi16(t, _mm256_setr_epi8(
+			10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1,
+			10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+		t = _mm256_madd_epi16(t, _mm256_setr_epi16(
+			100, 1, 100, 1, 100, 1, 100, 1, 100, 1, 100, 1, 100, 1, 100, 1));
+		t = _mm256_packus_epi32(t, t);
+		t = _mm256_madd_epi16(t, _mm256_setr_epi16(
+			10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1));
+		out0 = std::uint64_t(static_cast<std::uint32_t>(_mm256_extract_epi32(t, 0))) * 100000000u
+			+ static_cast<std::uint32_t>(_mm256_extract_epi32(t, 1));
+		out1 = std::uint64_t(static_cast<std::uint32_t>(_mm256_extract_epi32(t, 4))) * 100000000u
+			+ static_cast<std::uint32_t>(_mm256_extract_epi32(t, 5));
+	}
+#else
+	inline void parse_sixteen_digits_x2(const char* p0, const char* p1, std::uint64_t& out0, std::uint64_t& out1) noexcept
+	{
+		out0 = from_str_detail::parse_sixteen_digits(p0);
+		out1 = from_str_detail::parse_sixteen_digits(p1);
+	}
+#endif
+
+// -----------------------------------------------------------------------------
+//  classify_sixteen_chars
+// -----------------------------------------------------------------------------
+	/*
+		Classifies 16 characters starting at p.
+		Bit i of digits (resp. dots) is set if p[i] is a digit (resp. '.').
+	*/
+	struct char_class_masks {
+		unsigned digits;
+		unsigned dots;
+	};
+
+#if defined(QSB_SIMD_SSE41)
+	inline char_class_masks classify_sixteen_chars(const char* p) noexcept
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		const __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+		const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+		const __m128i is_dot = _mm_cmpeq_epi8(v, _mm_set1_epi8('.'));
+		return {
+			static_cast<unsigned>(_mm_movemask_epi8(is_digit)),
+			static_cast<unsigned>(_mm_movemask_epi8(is_dot))
+		};
+	}
+#else
+	inline char_class_masks classify_sixteen_chars(const char* p) noexcept
+	{
+		char_class_masks result = { 0u, 0u };
+		for (unsigned i = 0; i < 16; ++i) {
+			const auto d = static_cast<unsigned>(static_cast<unsigned char>(p[i])) - static_cast<unsigned>('0');
+			result.digits |= unsigned(d <= 9u) << i;
+			result.dots |= unsigned(p[i] == '.') << i;
+		}
+		return result;
+	}
+#endif
+
+}} // namespace qsb::from_str_detail
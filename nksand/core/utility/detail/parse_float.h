@@ -0,0 +1,523 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include "parse_digits.h"
+#include "parse_float_table.h"
+
+// -----------------------------------------------------------------------------
+//  QSB_IS_CONSTANT_EVALUATED
+// -----------------------------------------------------------------------------
+/*
+	std::is_constant_evaluated is C++20, but msvc, gcc and clang provide
+	the builtin also in C++17 mode.
+*/
+#if defined(__cpp_lib_is_constant_evaluated)
+#	define QSB_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#else
+#	define QSB_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+namespace qsb { namespace from_str_detail {
+// -----------------------------------------------------------------------------
+//  float_format
+// -----------------------------------------------------------------------------
+	template <typename T>
+	struct float_format;
+
+	template <>
+	struct float_format<double> {
+		using bits_type = std::uint64_t;
+		static constexpr int mantissa_explicit_bits = 52;
+		static constexpr int minimum_exponent = -1023;
+		static constexpr int infinite_power = 0x7FF;
+		static constexpr int sign_index = 63;
+		static constexpr int smallest_power_of_ten = -342;
+		static constexpr int largest_power_of_ten = 308;
+		static constexpr int min_exponent_round_to_even = -4;
+		static constexpr int max_exponent_round_to_even = 23;
+		static constexpr int min_exponent_fast_path = -22;
+		static constexpr int max_exponent_fast_path = 22;
+		static constexpr std::uint64_t max_mantissa_fast_path = std::uint64_t(2) << 52;
+	};
+
+	template <>
+	struct float_format<float> {
+		using bits_type = std::uint32_t;
+		static constexpr int mantissa_explicit_bits = 23;
+		static constexpr int minimum_exponent = -127;
+		static constexpr int infinite_power = 0xFF;
+		static constexpr int sign_index = 31;
+		static constexpr int smallest_power_of_ten = -64;
+		static constexpr int largest_power_of_ten = 38;
+		static constexpr int min_exponent_round_to_even = -17;
+		static constexpr int max_exponent_round_to_even = 10;
+		static constexpr int min_exponent_fast_path = -10;
+		static constexpr int max_exponent_fast_path = 10;
+		static constexpr std::uint64_t max_mantissa_fast_path = std::uint64_t(2) << 23;
+	};
+
+// -----------------------------------------------------------------------------
+//  decimal_number
+// -----------------------------------------------------------------------------
+	/*
+		Decimal representation of a number string.
+		value = (negative ? -1 : 1) * mantissa * 10^exponent
+
+		When the string has more than 19 significant digits,
+		mantissa holds the leading 19 digits and too_many_digits is set.
+	*/
+	struct decimal_number {
+		std::uint64_t mantissa = 0;
+		std::int64_t exponent = 0;
+		bool negative = false;
+		bool too_many_digits = false;
+	};
+
+	enum class decimal_kind {
+		invalid,
+		finite,
+		infinity,
+		nan,
+	};
+
+// -----------------------------------------------------------------------------
+//  is_digit
+// -----------------------------------------------------------------------------
+	constexpr bool is_digit(char c) noexcept
+	{
+		return static_cast<unsigned>(static_cast<unsigned char>(c)) - static_cast<unsigned>('0') <= 9u;
+	}
+
+// -----------------------------------------------------------------------------
+//  match_ignore_case
+// -----------------------------------------------------------------------------
+	// lower must be a lower case literal
+	constexpr bool match_ignore_case(const char* first, const char* last, std::string_view lower) noexcept
+	{
+		if (static_cast<std::size_t>(last - first) != lower.size()) {
+			return false;
+		}
+		for (std::size_t i = 0; i < lower.size(); ++i) {
+			const char c = first[i];
+			if ((c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c) != lower[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_decimal
+// -----------------------------------------------------------------------------
+	/*
+		Accepted format is
+			[+|-]digits[.[digits]][(e|E)[+|-]digits]
+			[+|-].digits[(e|E)[+|-]digits]
+			[+|-](inf|infinity|nan)	(case insensitive)
+		and the whole range must be consumed.
+	*/
+	constexpr decimal_kind parse_decimal(const char* first, const char* last, decimal_number& out) noexcept
+	{
+		constexpr std::uint64_t minimal_nineteen_digit_integer = 1000000000000000000u;
+
+		if (first != last && (*first == '+' || *first == '-')) {
+			out.negative = *first == '-';
+			++first;
+		}
+		if (first == last) {
+			return decimal_kind::invalid;
+		}
+		if (!is_digit(*first) && *first != '.') {
+			if (match_ignore_case(first, last, "inf") || match_ignore_case(first, last, "infinity")) {
+				return decimal_kind::infinity;
+			}
+			if (match_ignore_case(first, last, "nan")) {
+				return decimal_kind::nan;
+			}
+			return decimal_kind::invalid;
+		}
+
+		// integer part
+		const char* const int_first = first;
+		std::uint64_t mantissa = 0;
+		while (first != last && is_digit(*first)) {
+			mantissa = 10 * mantissa + static_cast<std::uint64_t>(*first - '0');
+			++first;
+		}
+		const char* const int_last = first;
+		std::int64_t digit_count = int_last - int_first;
+		std::int64_t exponent = 0;
+
+		// fraction part
+		const char* frac_first = first;
+		if (first != last && *first == '.') {
+			++first;
+			frac_first = first;
+			while (first != last && is_digit(*first)) {
+				mantissa = 10 * mantissa + static_cast<std::uint64_t>(*first - '0');
+				++first;
+			}
+			exponent = frac_first - first;
+			digit_count -= exponent;
+		}
+		const char* const frac_last = first;
+		if (digit_count == 0) {
+			return decimal_kind::invalid;
+		}
+
+		// exponent part
+		if (first != last && (*first == 'e' || *first == 'E')) {
+			++first;
+			bool negative_exponent = false;
+			if (first != last && (*first == '+' || *first == '-')) {
+				negative_exponent = *first == '-';
+				++first;
+			}
+			if (first == last || !is_digit(*first)) {
+				return decimal_kind::invalid;
+			}
+			std::int64_t exp_number = 0;
+			while (first != last && is_digit(*first)) {
+				if (exp_number < 0x10000000) {
+					exp_number = 10 * exp_number + (*first - '0');
+				}
+				++first;
+			}
+			exponent += negative_exponent ? -exp_number : exp_number;
+		}
+		if (first != last) {
+			return decimal_kind::invalid;
+		}
+
+		// more than 19 digits may overflow. leading zeros are not significant.
+		if (digit_count > 19) {
+			const char* p = int_first;
+			while (p != frac_last && (*p == '0' || *p == '.')) {
+				if (*p == '0') {
+					--digit_count;
+				}
+				++p;
+			}
+			if (digit_count > 19) {
+				out.too_many_digits = true;
+				mantissa = 0;
+				p = int_first;
+				while (mantissa < minimal_nineteen_digit_integer && p != int_last) {
+					mantissa = 10 * mantissa + static_cast<std::uint64_t>(*p - '0');
+					++p;
+				}
+				if (mantissa >= minimal_nineteen_digit_integer) {
+					exponent = (int_last - p) + (exponent + (frac_last - frac_first));
+				}
+				else {
+					const std::int64_t exp_number = exponent + (frac_last - frac_first);
+					p = frac_first;
+					while (mantissa < minimal_nineteen_digit_integer && p != frac_last) {
+						mantissa = 10 * mantissa + static_cast<std::uint64_t>(*p - '0');
+						++p;
+					}
+					exponent = (frac_first - p) + exp_number;
+				}
+			}
+		}
+
+		out.mantissa = mantissa;
+		out.exponent = exponent;
+		return decimal_kind::finite;
+	}
+
+// -----------------------------------------------------------------------------
+//  leading_zeroes
+// -----------------------------------------------------------------------------
+	constexpr int leading_zeroes(std::uint64_t x) noexcept
+	{
+		int n = 0;
+		for (int shift = 32; shift > 0; shift >>= 1) {
+			if ((x >> (64 - shift)) == 0) {
+				n += shift;
+				x <<= shift;
+			}
+		}
+		return n;
+	}
+
+// -----------------------------------------------------------------------------
+//  adjusted_mantissa
+// -----------------------------------------------------------------------------
+	// mantissa and biased exponent of a binary floating point number
+	struct adjusted_mantissa {
+		std::uint64_t mantissa = 0;
+		int power2 = 0;
+
+		constexpr bool operator ==(const adjusted_mantissa& other) const noexcept
+		{
+			return mantissa == other.mantissa && power2 == other.power2;
+		}
+	};
+
+// -----------------------------------------------------------------------------
+//  eisel_lemire
+// -----------------------------------------------------------------------------
+	/*
+		Computes the correctly rounded binary representation of w * 10^q.
+		https://arxiv.org/abs/2101.11408
+		With the 128-bit table, the result is exact for any 64-bit w
+		(Mushtak and Lemire, "Fast number parsing without fallback").
+	*/
+	template <typename T>
+	constexpr adjusted_mantissa eisel_lemire(std::int64_t q, std::uint64_t w) noexcept
+	{
+		using format = float_format<T>;
+		adjusted_mantissa answer;
+		if (w == 0 || q < format::smallest_power_of_ten) {
+			return answer;
+		}
+		if (q > format::largest_power_of_ten) {
+			answer.power2 = format::infinite_power;
+			return answer;
+		}
+
+		const int lz = leading_zeroes(w);
+		w <<= lz;
+
+		// product of w and 5^q with (mantissa_explicit_bits + 3) bits precision
+		constexpr int bit_precision = format::mantissa_explicit_bits + 3;
+		constexpr std::uint64_t precision_mask = ~std::uint64_t(0) >> bit_precision;
+		const auto index = static_cast<std::size_t>(2 * (q - power_of_five_128_min_exponent));
+		uint128 product = full_multiplication(w, power_of_five_128[index]);
+		if ((product.high & precision_mask) == precision_mask) {
+			const uint128 second = full_multiplication(w, power_of_five_128[index + 1]);
+			product.low += second.high;
+			if (second.high > product.low) {
+				++product.high;
+			}
+		}
+
+		const int upperbit = static_cast<int>(product.high >> 63);
+		const int shift = upperbit + 64 - format::mantissa_explicit_bits - 3;
+		answer.mantissa = product.high >> shift;
+		// floor(log2(10^q)) = floor(q * log2(5)) + q
+		const int power = static_cast<int>(((152170 + 65536) * q) >> 16) + 63;
+		answer.power2 = power + upperbit - lz - format::minimum_exponent;
+
+		if (answer.power2 <= 0) {
+			// subnormal
+			if (-answer.power2 + 1 >= 64) {
+				return adjusted_mantissa{};
+			}
+			answer.mantissa >>= -answer.power2 + 1;
+			answer.mantissa += (answer.mantissa & 1);
+			answer.mantissa >>= 1;
+			// rounding may carry into the smallest normal number
+			answer.power2 = answer.mantissa < (std::uint64_t(1) << format::mantissa_explicit_bits) ? 0 : 1;
+			return answer;
+		}
+
+		// exactly halfway between two floats: round to even
+		if (product.low <= 1 &&
+			q >= format::min_exponent_round_to_even && q <= format::max_exponent_round_to_even &&
+			(answer.mantissa & 3) == 1 &&
+			(answer.mantissa << shift) == product.high) {
+			answer.mantissa &= ~std::uint64_t(1);
+		}
+
+		answer.mantissa += (answer.mantissa & 1);
+		answer.mantissa >>= 1;
+		if (answer.mantissa >= (std::uint64_t(2) << format::mantissa_explicit_bits)) {
+			answer.mantissa = std::uint64_t(1) << format::mantissa_explicit_bits;
+			++answer.power2;
+		}
+		answer.mantissa &= ~(std::uint64_t(1) << format::mantissa_explicit_bits);
+		if (answer.power2 >= format::infinite_power) {
+			answer.power2 = format::infinite_power;
+			answer.mantissa = 0;
+		}
+		return answer;
+	}
+
+// -----------------------------------------------------------------------------
+//  to_float
+// -----------------------------------------------------------------------------
+	/*
+		Bit copy at run time. In constant evaluation, where memcpy is not allowed,
+		the finite value is built by multiplication by a power of 2, which is exact.
+	*/
+	template <typename T>
+	constexpr T to_float_by_arithmetic(adjusted_mantissa am, bool negative) noexcept
+	{
+		using format = float_format<T>;
+		const bool subnormal = am.power2 == 0;
+		const std::uint64_t significand = subnormal
+			? am.mantissa
+			: am.mantissa | (std::uint64_t(1) << format::mantissa_explicit_bits);
+		int exponent = (subnormal ? 1 : am.power2) + format::minimum_exponent - format::mantissa_explicit_bits;
+		T scale = 1;
+		for (; exponent > 0; --exponent) {
+			scale *= 2;
+		}
+		for (; exponent < 0; ++exponent) {
+			scale /= 2;
+		}
+		const T value = static_cast<T>(significand) * scale;
+		return negative ? -value : value;
+	}
+
+	template <typename T>
+	constexpr T to_float(adjusted_mantissa am, bool negative) noexcept
+	{
+		if (QSB_IS_CONSTANT_EVALUATED()) {
+			return from_str_detail::to_float_by_arithmetic<T>(am, negative);
+		}
+		using format = float_format<T>;
+		using bits_type = typename format::bits_type;
+		const auto bits = static_cast<bits_type>(
+			am.mantissa |
+			(static_cast<std::uint64_t>(am.power2) << format::mantissa_explicit_bits) |
+			(static_cast<std::uint64_t>(negative) << format::sign_index));
+		T result {};
+		std::memcpy(&result, &bits, sizeof(T));
+		return result;
+	}
+
+// -----------------------------------------------------------------------------
+//  fast_path_float
+// -----------------------------------------------------------------------------
+	/*
+		Clinger's fast path.
+		If the mantissa and 10^|exponent| are exactly representable,
+		a single multiplication or division is correctly rounded.
+	*/
+	template <typename T>
+	constexpr bool fast_path_appliable(const decimal_number& d) noexcept
+	{
+		using format = float_format<T>;
+		return !d.too_many_digits
+			&& d.mantissa <= format::max_mantissa_fast_path
+			&& format::min_exponent_fast_path <= d.exponent
+			&& d.exponent <= format::max_exponent_fast_path;
+	}
+
+	template <typename T>
+	constexpr T fast_path_float(const decimal_number& d) noexcept
+	{
+		constexpr T powers_of_ten[] = {
+			T(1e0), T(1e1), T(1e2), T(1e3), T(1e4), T(1e5), T(1e6), T(1e7),
+			T(1e8), T(1e9), T(1e10), T(1e11), T(1e12), T(1e13), T(1e14), T(1e15),
+			T(1e16), T(1e17), T(1e18), T(1e19), T(1e20), T(1e21), T(1e22),
+		};
+		T value = static_cast<T>(d.mantissa);
+		value = d.exponent < 0 ? value / powers_of_ten[-d.exponent] : value * powers_of_ten[d.exponent];
+		return d.negative ? -value : value;
+	}
+
+// -----------------------------------------------------------------------------
+//  from_chars_float
+// -----------------------------------------------------------------------------
+	/*
+		Fallback by std::from_chars, which is also locale-free and correctly rounded.
+		Used for ambiguous numbers with more than 19 digits and for long double.
+	*/
+	template <typename T>
+	traits::from_string_errc from_chars_float(const char* first, const char* last, T& out) noexcept
+	{
+		if (first != last && *first == '+') {
+			++first;
+			if (first != last && *first == '-') {
+				return traits::from_string_errc::invalid_argument;
+			}
+		}
+		T result {};
+		const auto [ptr, ec] = std::from_chars(first, last, result);
+		if (ec == std::errc::result_out_of_range) {
+			return traits::from_string_errc::out_of_range;
+		}
+		if (ec != std::errc{} || ptr != last) {
+			return traits::from_string_errc::invalid_argument;
+		}
+		out = result;
+		return traits::from_string_errc::ok;
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_float
+// -----------------------------------------------------------------------------
+	/*
+		Locale-free, correctly rounded parser for float and double.
+		Results are bit-identical to std::strtod/std::strtof for the accepted format.
+		(see parse_decimal. hexadecimal floats and white spaces are not accepted)
+
+		1. Clinger's fast path for short numbers such as quotes and rates
+		2. Eisel-Lemire algorithm
+		3. std::from_chars for ambiguous numbers with more than 19 digits
+
+		Overflow to infinity and underflow of non-zero numbers to zero are out_of_range.
+		out is untouched unless from_string_errc::ok is returned.
+
+		This is constexpr except for 3, so numbers with more than 19 significant digits
+		near a halfway point cannot be converted in constant evaluation.
+	*/
+	template <typename T>
+	constexpr traits::from_string_errc parse_float(const char* first, const char* last, T& out) noexcept
+	{
+		static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "T must be float or double.");
+
+		decimal_number d;
+		switch (from_str_detail::parse_decimal(first, last, d)) {
+		case decimal_kind::finite:
+			break;
+		case decimal_kind::infinity:
+			out = d.negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+			return traits::from_string_errc::ok;
+		case decimal_kind::nan:
+			out = d.negative ? -std::numeric_limits<T>::quiet_NaN() : std::numeric_limits<T>::quiet_NaN();
+			return traits::from_string_errc::ok;
+		default:
+			return traits::from_string_errc::invalid_argument;
+		}
+
+		if (from_str_detail::fast_path_appliable<T>(d)) {
+			out = from_str_detail::fast_path_float<T>(d);
+			return traits::from_string_errc::ok;
+		}
+
+		const adjusted_mantissa am = from_str_detail::eisel_lemire<T>(d.exponent, d.mantissa);
+		if (d.too_many_digits && !(am == from_str_detail::eisel_lemire<T>(d.exponent, d.mantissa + 1))) {
+			return from_str_detail::from_chars_float(first, last, out);
+		}
+		if (am.power2 == float_format<T>::infinite_power) {
+			return traits::from_string_errc::out_of_range;
+		}
+		if (am.power2 == 0 && am.mantissa == 0 && d.mantissa != 0) {
+			return traits::from_string_errc::out_of_range;
+		}
+		out = from_str_detail::to_float<T>(am, d.negative);
+		return traits::from_string_errc::ok;
+	}
+
+	inline traits::from_string_errc parse_float(const char* first, const char* last, long double& out) noexcept
+	{
+		if constexpr (std::numeric_limits<long double>::digits == std::numeric_limits<double>::digits) {
+			double result {};
+			const auto ec = from_str_detail::parse_float(first, last, result);
+			if (ec == traits::from_string_errc::ok) {
+				out = result;
+			}
+			return ec;
+		}
+		else {
+			return from_str_detail::from_chars_float(first, last, out);
+		}
+	}
+
+	template <typename T>
+	constexpr traits::from_string_errc parse_float(std::string_view str, T& out) noexcept
+	{
+		return from_str_detail::parse_float(str.data(), str.data() + str.size(), out);
+	}
+
+}} // namespace qsb::from_str_detail
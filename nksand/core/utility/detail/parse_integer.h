@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace qsb { namespace from_str_detail {
+// -----------------------------------------------------------------------------
+//  parse_integer
+// -----------------------------------------------------------------------------
+	/*
+		Locale-free and errno-free integer parser used by from_string_trait<integral>.
+
+		Accepted format is
+			[+|-]digits
+		and the whole range must be consumed. Unlike std::strtol, leading white spaces,
+		trailing characters, base prefixes and negative numbers for unsigned types are rejected.
+		Overflow is detected exactly for each type and reported as out_of_range.
+		out is untouched unless from_string_errc::ok is returned.
+	*/
+	template <typename T>
+	constexpr traits::from_string_errc parse_integer(const char* first, const char* last, T& out) noexcept
+	{
+		static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "T must be an integer type.");
+		using unsigned_type = std::make_unsigned_t<T>;
+
+		bool negative = false;
+		if (first != last && (*first == '+' || *first == '-')) {
+			negative = *first == '-';
+			++first;
+		}
+		if (first == last || (negative && std::is_unsigned_v<T>)) {
+			return traits::from_string_errc::invalid_argument;
+		}
+
+		// magnitude limit. -min is max + 1 for signed types
+		constexpr auto max_magnitude = static_cast<unsigned_type>(std::numeric_limits<T>::max());
+		const auto limit = static_cast<unsigned_type>(max_magnitude + (negative ? 1u : 0u));
+
+		// leading digits which never overflow
+		constexpr std::ptrdiff_t safe_digits = std::numeric_limits<unsigned_type>::digits10;
+		const char* const safe_last = last - first > safe_digits ? first + safe_digits : last;
+
+		unsigned_type value = 0;
+		for (; first != safe_last; ++first) {
+			const auto d = static_cast<unsigned>(static_cast<unsigned char>(*first)) - static_cast<unsigned>('0');
+			if (d > 9u) {
+				return traits::from_string_errc::invalid_argument;
+			}
+			value = static_cast<unsigned_type>(value * 10u + d);
+		}
+
+		bool overflow = value > limit;
+		for (; first != last; ++first) {
+			const auto d = static_cast<unsigned>(static_cast<unsigned char>(*first)) - static_cast<unsigned>('0');
+			if (d > 9u) {
+				return traits::from_string_errc::invalid_argument;
+			}
+			overflow = overflow || value > static_cast<unsigned_type>((limit - d) / 10u);
+			value = static_cast<unsigned_type>(value * 10u + d);
+		}
+		if (overflow) {
+			return traits::from_string_errc::out_of_range;
+		}
+
+		out = negative ? static_cast<T>(static_cast<unsigned_type>(0u - value)) : static_cast<T>(value);
+		return traits::from_string_errc::ok;
+	}
+
+	template <typename T>
+	constexpr traits::from_string_errc parse_integer(std::string_view str, T& out) noexcept
+	{
+		return from_str_detail::parse_integer(str.data(), str.data() + str.size(), out);
+	}
+
+}} // namespace qsb::from_str_detail
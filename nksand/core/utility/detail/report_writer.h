@@ -0,0 +1,131 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qsb { namespace report_detail {
+// -----------------------------------------------------------------------------
+//  write_chunks_sequential
+// -----------------------------------------------------------------------------
+	// format_chunk(std::string&, std::size_t chunk) appends the chunk to the buffer
+	template <typename F>
+	void write_chunks_sequential(std::ostream& out, std::size_t chunks, F& format_chunk)
+	{
+		std::string buffer;
+		for (std::size_t k = 0; k < chunks && out; ++k) {
+			buffer.clear();
+			format_chunk(buffer, k);
+			out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		}
+	}
+
+// -----------------------------------------------------------------------------
+//  write_chunks_parallel
+// -----------------------------------------------------------------------------
+	/*
+		Chunks are formatted by worker threads into a ring of in_flight buffers,
+		and the calling thread writes them to the stream in the order of chunks.
+		Chunk k is formatted into slot k % in_flight only after chunk k - in_flight is written,
+		so at most in_flight chunks are held at a time.
+		The first exception thrown by format_chunk, the stream or std::thread stops all threads,
+		and is rethrown after all started workers are joined.
+	*/
+	template <typename F>
+	void write_chunks_parallel(std::ostream& out, std::size_t chunks, std::size_t threads, std::size_t in_flight, F& format_chunk)
+	{
+		struct slot {
+			std::string buffer;
+			bool ready = false;
+		};
+		std::vector<slot> slots(in_flight);
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::size_t next = 0;
+		std::size_t written = 0;
+		bool stopped = false;
+		std::exception_ptr error;
+
+		const auto work = [&] {
+			for (;;) {
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&] { return stopped || next >= chunks || next < written + in_flight; });
+				if (stopped || next >= chunks) {
+					return;
+				}
+				const std::size_t k = next++;
+				lock.unlock();
+
+				slot& s = slots[k % in_flight];
+				s.buffer.clear();
+				try {
+					format_chunk(s.buffer, k);
+				}
+				catch (...) {
+					lock.lock();
+					if (!error) {
+						error = std::current_exception();
+					}
+					stopped = true;
+					changed.notify_all();
+					return;
+				}
+
+				lock.lock();
+				s.ready = true;
+				changed.notify_all();
+			}
+		};
+
+		std::vector<std::thread> workers;
+		try {
+			workers.reserve(threads);
+			for (std::size_t i = 0; i < threads; ++i) {
+				workers.emplace_back(work);
+			}
+
+			for (std::size_t k = 0; k < chunks; ++k) {
+				slot& s = slots[k % in_flight];
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					changed.wait(lock, [&] { return stopped || s.ready; });
+					if (stopped) {
+						break;
+					}
+				}
+				out.write(s.buffer.data(), static_cast<std::streamsize>(s.buffer.size()));
+
+				std::lock_guard<std::mutex> lock(mutex);
+				s.ready = false;
+				++written;
+				stopped = !out;
+				changed.notify_all();
+			}
+		}
+		catch (...) {
+			// workers must be joined before std::thread is destroyed
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopped = true;
+			changed.notify_all();
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+}} // namespace qsb::report_detail
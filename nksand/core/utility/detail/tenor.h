@@ -0,0 +1,140 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace qsb { namespace tenor_detail {
+// -----------------------------------------------------------------------------
+//  special_name_table
+// -----------------------------------------------------------------------------
+	/*
+		Perfect hash table of special tenor names.
+		Names are two upper case letters and the hash is chosen so that
+		they occupy distinct slots, which is checked at compile time.
+		A lookup is one hash, one load and one comparison.
+	*/
+	struct special_name {
+		char name[2];
+		tenor_unit unit;
+		bool used;
+	};
+
+	constexpr std::size_t special_name_table_size = 8;
+
+	constexpr std::size_t special_name_hash(char c0, char c1) noexcept
+	{
+		return (static_cast<std::size_t>(static_cast<unsigned char>(c0))
+			+ 3u * static_cast<std::size_t>(static_cast<unsigned char>(c1))) & (special_name_table_size - 1);
+	}
+
+	struct special_name_table {
+		std::array<special_name, special_name_table_size> slots {};
+		bool perfect = true;
+	};
+
+	constexpr special_name_table make_special_name_table(const special_name* first, const special_name* last) noexcept
+	{
+		special_name_table table;
+		for (; first != last; ++first) {
+			special_name& slot = table.slots[tenor_detail::special_name_hash(first->name[0], first->name[1])];
+			table.perfect = table.perfect && !slot.used;
+			slot = *first;
+			slot.used = true;
+		}
+		return table;
+	}
+
+	inline constexpr special_name special_names[] = {
+		{ { 'O', 'N' }, tenor_unit::overnight, false },
+		{ { 'T', 'N' }, tenor_unit::tomorrow_next, false },
+		{ { 'S', 'N' }, tenor_unit::spot_next, false },
+		{ { 'S', 'W' }, tenor_unit::spot_week, false },
+	};
+
+	inline constexpr special_name_table special_name_slots
+		= tenor_detail::make_special_name_table(std::begin(special_names), std::end(special_names));
+
+	static_assert(special_name_slots.perfect, "special_name_hash must be collision free for special_names.");
+
+// -----------------------------------------------------------------------------
+//  unit_letter_table
+// -----------------------------------------------------------------------------
+	/*
+		Unit of a letter indexed by its lower 5 bits, so that upper and lower cases share a slot.
+		Slots of other letters hold invalid_unit.
+	*/
+	constexpr std::uint8_t invalid_unit = 0xFF;
+
+	constexpr std::array<std::uint8_t, 32> make_unit_letter_table() noexcept
+	{
+		std::array<std::uint8_t, 32> table {};
+		for (auto& slot : table) {
+			slot = invalid_unit;
+		}
+		table['D' & 0x1F] = static_cast<std::uint8_t>(tenor_unit::day);
+		table['W' & 0x1F] = static_cast<std::uint8_t>(tenor_unit::week);
+		table['M' & 0x1F] = static_cast<std::uint8_t>(tenor_unit::month);
+		table['Y' & 0x1F] = static_cast<std::uint8_t>(tenor_unit::year);
+		return table;
+	}
+
+	inline constexpr std::array<std::uint8_t, 32> unit_letter_table = tenor_detail::make_unit_letter_table();
+
+// -----------------------------------------------------------------------------
+//  to_upper
+// -----------------------------------------------------------------------------
+	// ascii letters only. others are mapped to non letters or left as is
+	constexpr char to_upper(char c) noexcept
+	{
+		return ('a' <= c && c <= 'z') ? static_cast<char>(c - ('a' - 'A')) : c;
+	}
+
+// -----------------------------------------------------------------------------
+//  parse_tenor
+// -----------------------------------------------------------------------------
+	/*
+		Accepted formats are
+			1. special names ON, TN, SN and SW
+			2. count and unit, digits{1, 4}[D|W|M|Y]
+		Letters are case insensitive. out_count and out_unit are untouched unless ok is returned.
+	*/
+	constexpr std::size_t max_count_digits = 4;
+
+	constexpr traits::from_string_errc parse_tenor(std::string_view str, std::int32_t& out_count, tenor_unit& out_unit) noexcept
+	{
+		const std::size_t size = str.size();
+		if (size < 2 || size > max_count_digits + 1) {
+			return traits::from_string_errc::invalid_argument;
+		}
+
+		const char last = tenor_detail::to_upper(str[size - 1]);
+		if (size == 2 && !('0' <= str[0] && str[0] <= '9')) {
+			const char first = tenor_detail::to_upper(str[0]);
+			const special_name& slot = special_name_slots.slots[tenor_detail::special_name_hash(first, last)];
+			if (!slot.used || slot.name[0] != first || slot.name[1] != last) {
+				return traits::from_string_errc::invalid_argument;
+			}
+			out_count = 1;
+			out_unit = slot.unit;
+			return traits::from_string_errc::ok;
+		}
+
+		const std::uint8_t unit = ('A' <= last && last <= 'Z') ? unit_letter_table[last & 0x1F] : invalid_unit;
+		std::uint32_t count = 0;
+		bool digits = true;
+		for (std::size_t i = 0; i + 1 < size; ++i) {
+			const auto d = static_cast<unsigned>(static_cast<unsigned char>(str[i])) - static_cast<unsigned>('0');
+			digits = digits && d <= 9u;
+			count = count * 10u + d;
+		}
+		if (!digits || unit == invalid_unit) {
+			return traits::from_string_errc::invalid_argument;
+		}
+		out_count = static_cast<std::int32_t>(count);
+		out_unit = static_cast<tenor_unit>(unit);
+		return traits::from_string_errc::ok;
+	}
+
+}} // namespace qsb::tenor_detail
@@ -1,8 +1,19 @@
 #pragma once
 
-#include <type_traits>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include "../lazy_false.h"
+#include "format_fixed.h"
+#include "format_integer.h"
 
 namespace qsb { namespace to_str_detail {
 // -----------------------------------------------------------------------------
@@ -77,6 +88,299 @@ namespace qsb { namespace to_str_detail {
 	template <typename T, typename ...Args>
 	using trait_appliable = decltype(trait_appliable_impl(std::declval<T>(), std::declval<Args>()...));
 
+// -----------------------------------------------------------------------------
+//  copy_chars
+// -----------------------------------------------------------------------------
+	// nullptr if [first, last) is too short
+	inline char* copy_chars(char* first, char* last, std::string_view str) noexcept
+	{
+		if (static_cast<std::size_t>(last - first) < str.size()) {
+			return nullptr;
+		}
+		std::memcpy(first, str.data(), str.size());
+		return first + str.size();
+	}
+
+// -----------------------------------------------------------------------------
+//	tags for dispatch of to_chars_trait
+// -----------------------------------------------------------------------------
+	struct string_adapter_tag {};
+	struct direct_adapter_tag : string_adapter_tag {};
+
+// -----------------------------------------------------------------------------
+//  to_chars_trait
+// -----------------------------------------------------------------------------
+	/*
+		Invokes Trait::to_chars if it is provided.
+		Otherwise, the string made by Trait::apply is copied.
+	*/
+	template <typename Trait, typename T>
+	auto to_chars_trait_impl(char* first, char* last, T&& value, direct_adapter_tag)
+		-> decltype(Trait::to_chars(first, last, std::forward<T>(value)))
+	{
+		return Trait::to_chars(first, last, std::forward<T>(value));
+	}
+
+	template <typename Trait, typename T>
+	char* to_chars_trait_impl(char* first, char* last, T&& value, string_adapter_tag)
+	{
+		return to_str_detail::copy_chars(first, last, Trait::apply(std::forward<T>(value)));
+	}
+
+	template <typename Trait, typename T>
+	char* to_chars_trait(char* first, char* last, T&& value)
+	{
+		return to_str_detail::to_chars_trait_impl<Trait>(first, last, std::forward<T>(value), direct_adapter_tag{});
+	}
+
+// -----------------------------------------------------------------------------
+//  append_chars
+// -----------------------------------------------------------------------------
+	/*
+		Appends characters written by f(first, last) -> char* to a growable buffer,
+		such as std::string and std::vector<char>.
+		f returns nullptr if the room is too short, and it is retried with a doubled room.
+		Returns the end of the buffer.
+	*/
+	template <typename Buffer, typename F>
+	char* append_chars(Buffer& buffer, F&& f)
+	{
+		const std::size_t offset = buffer.size();
+		for (std::size_t room = 32;; room *= 2) {
+			buffer.resize(offset + room);
+			char* const first = buffer.data() + offset;
+			if (char* const end = f(first, first + room)) {
+				buffer.resize(offset + static_cast<std::size_t>(end - first));
+				return buffer.data() + buffer.size();
+			}
+		}
+	}
+
+// -----------------------------------------------------------------------------
+//  append_text
+// -----------------------------------------------------------------------------
+	template <typename Buffer>
+	void append_text(Buffer& buffer, std::string_view text)
+	{
+		buffer.insert(buffer.end(), text.begin(), text.end());
+	}
+
+// -----------------------------------------------------------------------------
+//  reserve_for
+// -----------------------------------------------------------------------------
+	// keeps the geometric growth so that repeated appends do not reallocate every time
+	template <typename Buffer>
+	void reserve_for(Buffer& buffer, std::size_t extra)
+	{
+		const std::size_t required = buffer.size() + extra;
+		if (buffer.capacity() < required) {
+			buffer.reserve(required < 2 * buffer.capacity() ? 2 * buffer.capacity() : required);
+		}
+	}
+
+// -----------------------------------------------------------------------------
+//  writable
+// -----------------------------------------------------------------------------
+	auto trait_writable_impl(...) -> std::false_type;
+
+	template <typename Trait, typename T>
+	auto trait_writable_impl(Trait, T&&) -> decltype(Trait::write(std::declval<std::string&>(), std::declval<T>()), std::true_type{});
+
+	// true if write_string_trait<T> is specialized
+	template <typename T>
+	using writable = decltype(trait_writable_impl(std::declval<traits::write_string_trait<T>>(), std::declval<const T&>()));
+
+	auto trait_estimable_impl(...) -> std::false_type;
+
+	template <typename Trait, typename T>
+	auto trait_estimable_impl(Trait, T&&) -> decltype(Trait::estimate_size(std::declval<T>()), std::true_type{});
+
+	template <typename T>
+	using estimable = decltype(trait_estimable_impl(std::declval<traits::write_string_trait<T>>(), std::declval<const T&>()));
+
+// -----------------------------------------------------------------------------
+//  write_value
+// -----------------------------------------------------------------------------
+	/*
+		Appends the string of a value to a sink.
+		write_string_trait<T> is used if it is specialized,
+		and otherwise to_string_trait<T> writes into the sink by to_chars.
+	*/
+	template <typename Sink, typename T>
+	void write_value(Sink& sink, const T& value)
+	{
+		if constexpr (writable<T>::value) {
+			traits::write_string_trait<T>::write(sink, value);
+		}
+		else {
+			to_str_detail::append_chars(sink, [&value](char* first, char* last) {
+				return to_str_detail::to_chars_trait<traits::to_string_trait<T>>(first, last, value);
+			});
+		}
+	}
+
+// -----------------------------------------------------------------------------
+//  estimate_value_size
+// -----------------------------------------------------------------------------
+	/*
+		Estimated length of the string of a value, used to reserve a sink once before writing.
+		This is exact or an upper bound for numbers and strings,
+		and a guess for other types without write_string_trait<T>::estimate_size.
+	*/
+	constexpr std::size_t default_estimated_size = 16;
+
+	template <typename T>
+	std::size_t estimate_value_size(const T& value) noexcept
+	{
+		if constexpr (estimable<T>::value) {
+			return traits::write_string_trait<T>::estimate_size(value);
+		}
+		else if constexpr (std::is_integral_v<T>) {
+			return std::numeric_limits<T>::digits10 + 2;
+		}
+		else if constexpr (std::is_floating_point_v<T>) {
+			// sign, '.' and exponent such as "e-308"
+			return std::numeric_limits<T>::max_digits10 + 8;
+		}
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+			return std::string_view(value).size();
+		}
+		else {
+			return default_estimated_size;
+		}
+	}
+
+// -----------------------------------------------------------------------------
+//  is_container
+// -----------------------------------------------------------------------------
+	auto is_container_impl(...) -> std::false_type;
+
+	template <typename T>
+	auto is_container_impl(T&& x) -> decltype(std::begin(x), std::end(x), std::true_type{});
+
+	// ranges other than strings, which are not convertible to std::string by get_tag
+	template <typename T>
+	constexpr bool is_container_v = decltype(is_container_impl(std::declval<const T&>()))::value
+		&& !std::is_convertible_v<const T&, std::string_view>
+		&& std::is_same_v<get_tag<const T&>, not_defined_tag>;
+
+// -----------------------------------------------------------------------------
+//  to_chars_number
+// -----------------------------------------------------------------------------
+	// std::to_chars, which reports too short range by nullptr
+	template <typename T, typename ...Args>
+	char* to_chars_number(char* first, char* last, T value, Args... args) noexcept
+	{
+		const auto result = std::to_chars(first, last, value, args...);
+		return result.ec == std::errc{} ? result.ptr : nullptr;
+	}
+
+// -----------------------------------------------------------------------------
+//  to_chars_fixed
+// -----------------------------------------------------------------------------
+	/*
+		Same as printf("%*.*f", width, prec, d) in "C" locale.
+		A negative prec means the default precision 6,
+		and a negative width means the left justification.
+		Values in the range of format_fixed_fast are written by it,
+		and the others by std::to_chars.
+	*/
+	inline char* fixed_chars(char* first, char* last, double d, int prec) noexcept
+	{
+		if (static_cast<std::size_t>(last - first) >= max_fixed_fast_size) {
+			if (char* const end = to_str_detail::format_fixed_fast(first, d, prec)) {
+				return end;
+			}
+		}
+		else {
+			char buffer[max_fixed_fast_size];
+			if (char* const end = to_str_detail::format_fixed_fast(buffer, d, prec)) {
+				return to_str_detail::copy_chars(first, last, std::string_view(buffer, static_cast<std::size_t>(end - buffer)));
+			}
+		}
+		return to_str_detail::to_chars_number(first, last, d, std::chars_format::fixed, prec);
+	}
+
+	inline char* to_chars_fixed(char* first, char* last, double d, int prec, int width) noexcept
+	{
+		char* const end = to_str_detail::fixed_chars(first, last, d, prec < 0 ? 6 : prec);
+		if (!end) {
+			return nullptr;
+		}
+
+		const bool left = width < 0;
+		const std::size_t padded = left ? 0u - static_cast<std::size_t>(width) : static_cast<std::size_t>(width);
+		const auto size = static_cast<std::size_t>(end - first);
+		if (size >= padded) {
+			return end;
+		}
+		if (static_cast<std::size_t>(last - first) < padded) {
+			return nullptr;
+		}
+		if (left) {
+			std::memset(end, ' ', padded - size);
+		}
+		else {
+			std::memmove(first + (padded - size), first, size);
+			std::memset(first, ' ', padded - size);
+		}
+		return first + padded;
+	}
+
+// -----------------------------------------------------------------------------
+//  to_string_from_integer_impl
+// -----------------------------------------------------------------------------
+	/*
+		Integers are written by format_integer, i.e. two digits per step by a table
+		after the count of digits, into the caller's buffer or a buffer on the stack.
+		bool and character types are written as numbers as std::to_string does.
+	*/
+	template <typename T>
+	struct to_string_from_integer_impl {
+	private:
+		using this_type = to_string_from_integer_impl;
+
+	public:
+		static char* to_chars(char* first, char* last, T value) noexcept
+		{
+			return to_str_detail::format_integer(first, last, value);
+		}
+
+		static std::string apply(T value)
+		{
+			char buffer[max_integer_size + 1];
+			return std::string(buffer, this_type::to_chars(buffer, buffer + sizeof(buffer), value));
+		}
+	};
+
+// -----------------------------------------------------------------------------
+//  to_string_from_float_impl
+// -----------------------------------------------------------------------------
+	/*
+		Floating point numbers are written in the shortest representation
+		which is read back to the same value, by std::to_chars without format and precision
+		(Ryu based in msvc and gcc).
+		Fixed or scientific notation is chosen by the shorter one, ex. "0.25", "1.2e-07" and "1e+20".
+		util::from_string<T> of the result reproduces the bits of the value.
+	*/
+	template <typename T>
+	struct to_string_from_float_impl {
+	private:
+		using this_type = to_string_from_float_impl;
+
+	public:
+		static char* to_chars(char* first, char* last, T value) noexcept
+		{
+			return to_str_detail::to_chars_number(first, last, value);
+		}
+
+		static std::string apply(T value)
+		{
+			char buffer[64];
+			return std::string(buffer, this_type::to_chars(buffer, buffer + sizeof(buffer), value));
+		}
+	};
+
 }} // namespace qsb::to_str_detail
 
 namespace qsb { namespace traits {
@@ -134,13 +438,51 @@ namespace qsb { namespace traits {
 			static_assert(std::is_same_v<T, to_str_detail::remove_cvref_t<AT>>, "impl.error. type mismatch.");
 			return this_type::apply(std::forward<AT>(value), to_str_detail::get_tag<AT>{});
 		}
+
+		// types without the above which have write_string_trait
+		template <typename AT, std::enable_if_t<
+			std::is_same_v<to_str_detail::not_defined_tag, to_str_detail::get_tag<AT>> && to_str_detail::writable<T>::value,
+			std::nullptr_t
+		> = nullptr>
+		static std::string apply(AT&& value)
+		{
+			static_assert(std::is_same_v<T, to_str_detail::remove_cvref_t<AT>>, "impl.error. type mismatch.");
+			std::string result;
+			result.reserve(to_str_detail::estimate_value_size<T>(value));
+			to_str_detail::write_value<std::string, T>(result, value);
+			return result;
+		}
 	};
 
+// -----------------------------------------------------------------------------
+//  to_string_trait<number>
+// -----------------------------------------------------------------------------
+	template <> struct to_string_trait<bool> : to_str_detail::to_string_from_integer_impl<bool> {};
+	template <> struct to_string_trait<char> : to_str_detail::to_string_from_integer_impl<char> {};
+	template <> struct to_string_trait<signed char> : to_str_detail::to_string_from_integer_impl<signed char> {};
+	template <> struct to_string_trait<unsigned char> : to_str_detail::to_string_from_integer_impl<unsigned char> {};
+	template <> struct to_string_trait<short> : to_str_detail::to_string_from_integer_impl<short> {};
+	template <> struct to_string_trait<unsigned short> : to_str_detail::to_string_from_integer_impl<unsigned short> {};
+	template <> struct to_string_trait<int> : to_str_detail::to_string_from_integer_impl<int> {};
+	template <> struct to_string_trait<unsigned> : to_str_detail::to_string_from_integer_impl<unsigned> {};
+	template <> struct to_string_trait<long> : to_str_detail::to_string_from_integer_impl<long> {};
+	template <> struct to_string_trait<unsigned long> : to_str_detail::to_string_from_integer_impl<unsigned long> {};
+	template <> struct to_string_trait<long long> : to_str_detail::to_string_from_integer_impl<long long> {};
+	template <> struct to_string_trait<unsigned long long> : to_str_detail::to_string_from_integer_impl<unsigned long long> {};
+	template <> struct to_string_trait<float> : to_str_detail::to_string_from_float_impl<float> {};
+	template <> struct to_string_trait<double> : to_str_detail::to_string_from_float_impl<double> {};
+	template <> struct to_string_trait<long double> : to_str_detail::to_string_from_float_impl<long double> {};
+
 // -----------------------------------------------------------------------------
 //  to_string_trait<std::string>
 // -----------------------------------------------------------------------------
 	template <>
 	struct to_string_trait<std::string> {
+		static char* to_chars(char* first, char* last, const std::string& str) noexcept
+		{
+			return to_str_detail::copy_chars(first, last, str);
+		}
+
 		static std::string apply(std::string&& str)
 		{
 			return std::move(str);
@@ -152,4 +494,123 @@ namespace qsb { namespace traits {
 		}
 	};
 
+// -----------------------------------------------------------------------------
+//  to_string_trait<std::string_view>
+//  to_string_trait<char[N]>
+// -----------------------------------------------------------------------------
+	template <>
+	struct to_string_trait<std::string_view> {
+		static char* to_chars(char* first, char* last, std::string_view str) noexcept
+		{
+			return to_str_detail::copy_chars(first, last, str);
+		}
+
+		static std::string apply(std::string_view str)
+		{
+			return std::string(str);
+		}
+	};
+
+	template <std::size_t N>
+	struct to_string_trait<char[N]> {
+		static char* to_chars(char* first, char* last, const char* str) noexcept
+		{
+			return to_str_detail::copy_chars(first, last, str);
+		}
+
+		static std::string apply(const char* str)
+		{
+			return std::string(str);
+		}
+	};
+
+// -----------------------------------------------------------------------------
+//  write_string_trait
+// -----------------------------------------------------------------------------
+	// not writable unless specialized
+	template <typename T, typename>
+	struct write_string_trait {};
+
+// -----------------------------------------------------------------------------
+//  write_string_trait<container>
+// -----------------------------------------------------------------------------
+	// "[x0, x1, ...]"
+	template <typename T>
+	struct write_string_trait<T, std::enable_if_t<to_str_detail::is_container_v<T>>> {
+		template <typename Sink>
+		static void write(Sink& sink, const T& values)
+		{
+			to_str_detail::append_text(sink, "[");
+			bool head = true;
+			for (const auto& value : values) {
+				to_str_detail::append_text(sink, head ? "" : ", ");
+				to_str_detail::write_value(sink, value);
+				head = false;
+			}
+			to_str_detail::append_text(sink, "]");
+		}
+
+		static std::size_t estimate_size(const T& values) noexcept
+		{
+			std::size_t size = 2;
+			for (const auto& value : values) {
+				size += to_str_detail::estimate_value_size(value) + 2;
+			}
+			return size;
+		}
+	};
+
+// -----------------------------------------------------------------------------
+//  write_string_trait<std::pair>
+//  write_string_trait<std::tuple>
+// -----------------------------------------------------------------------------
+	// "(x0, x1, ...)"
+	template <typename ...Ts>
+	struct write_string_trait<std::tuple<Ts...>> {
+	private:
+		template <typename Sink, std::size_t ...Is>
+		static void write_elements(Sink& sink, const std::tuple<Ts...>& values, std::index_sequence<Is...>)
+		{
+			((to_str_detail::append_text(sink, Is == 0 ? "" : ", "), to_str_detail::write_value(sink, std::get<Is>(values))), ...);
+		}
+
+		template <std::size_t ...Is>
+		static std::size_t estimate_elements(const std::tuple<Ts...>& values, std::index_sequence<Is...>) noexcept
+		{
+			return (std::size_t(2) + ... + (to_str_detail::estimate_value_size(std::get<Is>(values)) + 2));
+		}
+
+	public:
+		template <typename Sink>
+		static void write(Sink& sink, const std::tuple<Ts...>& values)
+		{
+			to_str_detail::append_text(sink, "(");
+			write_elements(sink, values, std::index_sequence_for<Ts...>{});
+			to_str_detail::append_text(sink, ")");
+		}
+
+		static std::size_t estimate_size(const std::tuple<Ts...>& values) noexcept
+		{
+			return estimate_elements(values, std::index_sequence_for<Ts...>{});
+		}
+	};
+
+	template <typename T1, typename T2>
+	struct write_string_trait<std::pair<T1, T2>> {
+		template <typename Sink>
+		static void write(Sink& sink, const std::pair<T1, T2>& values)
+		{
+			to_str_detail::append_text(sink, "(");
+			to_str_detail::write_value(sink, values.first);
+			to_str_detail::append_text(sink, ", ");
+			to_str_detail::write_value(sink, values.second);
+			to_str_detail::append_text(sink, ")");
+		}
+
+		static std::size_t estimate_size(const std::pair<T1, T2>& values) noexcept
+		{
+			return to_str_detail::estimate_value_size(values.first) + to_str_detail::estimate_value_size(values.second) + 4;
+		}
+	};
+
 }} // namespace qsb::traits
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "from_str.h"
+#include "detail/fixed_decimal.h"
+
+namespace qsb {
+// -----------------------------------------------------------------------------
+//  fixed_decimal
+// -----------------------------------------------------------------------------
+	/*
+		Decimal number of a fixed format, held as an integer scaled by 10^FractionDigits.
+		This is a parse mode for fields whose shape is known in advance,
+		such as rates "0.012345" (fixed_decimal<1, 6>) and prices "99.8750" (fixed_decimal<3, 4>).
+
+		Accepted format is
+			[+|-]d{1, IntegerDigits}.d{FractionDigits}
+		i.e. at most IntegerDigits integer digits and exactly FractionDigits fraction digits
+		('.' is omitted when FractionDigits is 0).
+		Other shapes, including exponents, are rejected, so use from_string_trait<double>
+		for free format fields.
+
+		Digits are converted by 8/16 digits SWAR/SIMD kernels without branches per character,
+		and util::from_string_batch converts two fields at a time.
+		to_double returns the correctly rounded value, i.e. the same as parsing the field as double.
+
+		ex)
+			using rate = qsb::fixed_decimal<1, 6>;
+			const auto r = qsb::util::from_string<rate>("0.012345");
+			r.scaled();		// 12345
+			r.to_double();	// 0.012345
+			r.to_string();	// "0.012345"
+	*/
+	template <std::size_t IntegerDigits, std::size_t FractionDigits>
+	class fixed_decimal {
+	private:
+		using this_type = fixed_decimal;
+		static_assert(IntegerDigits >= 1, "at least 1 integer digit is required.");
+		static_assert(IntegerDigits + FractionDigits <= 16, "at most 16 digits are supported.");
+
+	public:
+		static constexpr std::size_t integer_digits = IntegerDigits;
+		static constexpr std::size_t fraction_digits = FractionDigits;
+		static constexpr std::int64_t scale = from_str_detail::pow10_i64(FractionDigits);
+
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		constexpr fixed_decimal() noexcept = default;
+
+		static constexpr this_type from_scaled(std::int64_t scaled) noexcept
+		{
+			this_type result;
+			result.scaled_ = scaled;
+			return result;
+		}
+
+	// -------------------------------------------------------------------------
+	//  get
+	//
+		constexpr std::int64_t scaled() const noexcept
+		{
+			return scaled_;
+		}
+
+		double to_double() const noexcept
+		{
+			return from_str_detail::scaled_to_float<double>(scaled_, FractionDigits);
+		}
+
+		std::string to_string() const
+		{
+			return from_str_detail::scaled_to_string(scaled_, FractionDigits);
+		}
+
+	// -------------------------------------------------------------------------
+	//  comparison
+	//
+		friend constexpr bool operator ==(const this_type& l, const this_type& r) noexcept { return l.scaled_ == r.scaled_; }
+		friend constexpr bool operator !=(const this_type& l, const this_type& r) noexcept { return l.scaled_ != r.scaled_; }
+		friend constexpr bool operator <(const this_type& l, const this_type& r) noexcept { return l.scaled_ < r.scaled_; }
+		friend constexpr bool operator >(const this_type& l, const this_type& r) noexcept { return l.scaled_ > r.scaled_; }
+		friend constexpr bool operator <=(const this_type& l, const this_type& r) noexcept { return l.scaled_ <= r.scaled_; }
+		friend constexpr bool operator >=(const this_type& l, const this_type& r) noexcept { return l.scaled_ >= r.scaled_; }
+
+	private:
+		std::int64_t scaled_ = 0;
+
+	}; // class fixed_decimal
+
+} // namespace qsb
+
+namespace qsb { namespace traits {
+// -----------------------------------------------------------------------------
+//  from_string_trait<fixed_decimal>
+// -----------------------------------------------------------------------------
+	template <std::size_t IntegerDigits, std::size_t FractionDigits>
+	struct from_string_trait<fixed_decimal<IntegerDigits, FractionDigits>> {
+	private:
+		using this_type = from_string_trait;
+		using value_type = fixed_decimal<IntegerDigits, FractionDigits>;
+
+	public:
+		static from_string_errc try_apply(std::string_view str, value_type& out) noexcept
+		{
+			std::int64_t scaled = 0;
+			const auto ec = from_str_detail::parse_fixed<IntegerDigits, FractionDigits>(str, scaled);
+			if (ec == from_string_errc::ok) {
+				out = value_type::from_scaled(scaled);
+			}
+			return ec;
+		}
+
+		static value_type apply(std::string_view str)
+		{
+			value_type result;
+			from_str_detail::throw_if_failed(this_type::try_apply(str, result));
+			return result;
+		}
+
+		static std::size_t try_apply_batch(span<const std::string_view> strs, span<value_type> out, util::bitmap& valid) noexcept
+		{
+			return from_str_detail::parse_fixed_batch<IntegerDigits, FractionDigits>(strs, out, valid);
+		}
+	};
+
+}} // namespace qsb::traits
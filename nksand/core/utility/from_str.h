@@ -1,6 +1,21 @@
 #pragma once
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "../ranges.h"
+#include "bitmap.h"
 #include "optional.h"
 
+// -----------------------------------------------------------------------------
+//  QSB_CONSTEVAL
+// -----------------------------------------------------------------------------
+#if defined(__cpp_consteval)
+#	define QSB_CONSTEVAL consteval
+#else
+#	define QSB_CONSTEVAL constexpr
+#endif
+
 namespace qsb { namespace traits {
 // -----------------------------------------------------------------------------
 //  from_string_trait
@@ -10,13 +25,30 @@ namespace qsb { namespace traits {
 	 
 		traits::from_string_trait is a customization point for util::from_string.
 		Default implementation is the followings:
-			1. direct convert from const char*
+			1. direct convert from const char* (or std::string_view if possible)
 			2. convert to number such as int, long and double
 			3. static from_string method (T::from_string(const char*))
 			4. static from_str method (T::from_str(const char*))
 		
 		So even when we do not provide a specialization of this trait, 
 		util::from_string works well if either of the above is defined. 
+
+		A specialization can accept const char*, std::string_view or both.
+		When only const char* is accepted, std::string_view inputs are passed
+		as a null terminated copy (on stack for short strings).
+		Accept std::string_view to parse fields in a loaded buffer without copy.
+
+		In addition to apply, a specialization can provide a non-throwing protocol
+			static from_string_errc try_apply(const char* str, T& out);
+		which stores the result into out and returns from_string_errc::ok,
+		or returns an error code leaving out untouched (malformed inputs are
+		reported by the code, not by an exception).
+		util::safe_from_string and util::try_from_string prefer try_apply,
+		so malformed inputs are rejected without throw/catch.
+		When try_apply is not provided, they fall back to apply with try-catch.
+		Default implementation provides try_apply for numbers and for types with
+			1. static try_from_string method (bool T::try_from_string(const char*, T&))
+			2. static try_from_str method (bool T::try_from_str(const char*, T&))
 	
 		ex)
 			namespace test {
@@ -37,28 +69,66 @@ namespace qsb { namespace traits {
 	template <typename T, typename = void>
 	struct from_string_trait;
 
+// -----------------------------------------------------------------------------
+//  from_string_errc
+// -----------------------------------------------------------------------------
+	enum class from_string_errc {
+		ok = 0,
+		invalid_argument,
+		out_of_range,
+	};
+
 }} // namespace qsb::traits
 
 #include "detail/from_str.h"
+#include "detail/from_str_batch.h"
 
 namespace qsb { namespace util {
 // -----------------------------------------------------------------------------
 //  from_string	: const char* -> T
 // 	from_str	: const char* -> T
+//  from_string	: std::string_view -> T
+// 	from_str	: std::string_view -> T
 // -----------------------------------------------------------------------------
+	/*
+		std::string_view overloads parse a range without null terminator,
+		so that fields in a loaded buffer can be converted in place.
+		(std::string is accepted through std::string_view)
+
+		These are constexpr if from_string_trait<T>::apply is,
+		as for numbers, so that literals can be converted at compile time.
+			constexpr double spread = qsb::util::from_str<double>("0.0025");
+	*/
 	template <typename T, std::enable_if_t<
-		from_str_detail::trait_appliable<traits::from_string_trait<T>, const char*>::value,
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
 	std::nullptr_t> = nullptr>
-	T from_string(const char* str)
+	constexpr T from_string(const char* str)
 	{
 		using from_string = traits::from_string_trait<T>;
-		return from_string::apply(str);
+		return from_str_detail::apply_trait<from_string>(str);
 	}
 
 	template <typename T, std::enable_if_t<
-		from_str_detail::trait_appliable<traits::from_string_trait<T>, const char*>::value,
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
 	std::nullptr_t> = nullptr>
-	T from_str(const char* str)
+	constexpr T from_string(std::string_view str)
+	{
+		using from_string = traits::from_string_trait<T>;
+		return from_str_detail::apply_trait<from_string>(str);
+	}
+
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	constexpr T from_str(const char* str)
+	{
+		return util::from_string<T>(str);
+	}
+
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	constexpr T from_str(std::string_view str)
 	{
 		return util::from_string<T>(str);
 	}
@@ -66,9 +136,11 @@ namespace qsb { namespace util {
 // -----------------------------------------------------------------------------
 //  from_string	: (const char*, T&) -> void
 // 	from_str	: (const char*, T&) -> void
+//  from_string	: (std::string_view, T&) -> void
+// 	from_str	: (std::string_view, T&) -> void
 // -----------------------------------------------------------------------------
 	template <typename T, std::enable_if_t<
-		from_str_detail::trait_appliable<traits::from_string_trait<T>, const char*>::value,
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
 	std::nullptr_t> = nullptr>
 	void from_string(const char* str, T& ref)
 	{
@@ -76,29 +148,63 @@ namespace qsb { namespace util {
 	}
 
 	template <typename T, std::enable_if_t<
-		from_str_detail::trait_appliable<traits::from_string_trait<T>, const char*>::value,
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	void from_string(std::string_view str, T& ref)
+	{
+		ref = util::from_string<T>(str);
+	}
+
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
 	std::nullptr_t> = nullptr>
 	void from_str(const char* str, T& ref)
 	{
 		ref = util::from_string<T>(str);
 	}
 
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	void from_str(std::string_view str, T& ref)
+	{
+		ref = util::from_string<T>(str);
+	}
+
 // -----------------------------------------------------------------------------
 //  safe_from_string : const char* -> optional<T>
 // 	safe_from_str    : const char* -> optional<T>
+//  safe_from_string : std::string_view -> optional<T>
+// 	safe_from_str    : std::string_view -> optional<T>
 // -----------------------------------------------------------------------------
 	template <typename T, std::enable_if_t<
-		from_str_detail::trait_appliable<traits::from_string_trait<T>, const char*>::value,
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
 	std::nullptr_t> = nullptr>
-	optional<T> safe_from_string(const char* str)
+	constexpr optional<T> safe_from_string(const char* str)
 	{
-		return from_string<optional<T>>(str);
+		return util::from_string<optional<T>>(str);
 	}
 
 	template <typename T, std::enable_if_t<
-		from_str_detail::trait_appliable<traits::from_string_trait<T>, const char*>::value,
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
 	std::nullptr_t> = nullptr>
-	optional<T> safe_from_str(const char* str)
+	constexpr optional<T> safe_from_string(std::string_view str)
+	{
+		return util::from_string<optional<T>>(str);
+	}
+
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	constexpr optional<T> safe_from_str(const char* str)
+	{
+		return util::safe_from_string<T>(str);
+	}
+
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	constexpr optional<T> safe_from_str(std::string_view str)
 	{
 		return util::safe_from_string<T>(str);
 	}
@@ -106,31 +212,96 @@ namespace qsb { namespace util {
 // -----------------------------------------------------------------------------
 //  try_from_string : (const char*, T&) -> bool
 // 	try_from_str	: (const char*, T&) -> bool
+//  try_from_string : (std::string_view, T&) -> bool
+// 	try_from_str	: (std::string_view, T&) -> bool
 // -----------------------------------------------------------------------------
 	template <typename T, std::enable_if_t<
-		from_str_detail::trait_appliable<traits::from_string_trait<T>, const char*>::value,
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
 	std::nullptr_t> = nullptr>
-	bool try_from_string(const char* str, T& ref)
+	constexpr bool try_from_string(const char* str, T& ref)
 	{
-		const auto opt = safe_from_string<T>(str);
-		if (opt) {
-			ref = opt.value();
-			return true;
-		}
-		return false;
+		using from_string = traits::from_string_trait<T>;
+		return from_str_detail::try_apply_trait<from_string>(str, ref) == traits::from_string_errc::ok;
+	}
+
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	constexpr bool try_from_string(std::string_view str, T& ref)
+	{
+		using from_string = traits::from_string_trait<T>;
+		return from_str_detail::try_apply_trait<from_string>(str, ref) == traits::from_string_errc::ok;
 	}
 
 	template <typename T, std::enable_if_t<
-		from_str_detail::trait_appliable<traits::from_string_trait<T>, const char*>::value,
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
 	std::nullptr_t> = nullptr>
-	bool try_from_str(const char* str, T& ref)
+	constexpr bool try_from_str(const char* str, T& ref)
 	{
 		return util::try_from_string(str, ref);
 	}
 
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	constexpr bool try_from_str(std::string_view str, T& ref)
+	{
+		return util::try_from_string(str, ref);
+	}
+
+// -----------------------------------------------------------------------------
+//  from_string_batch : (span<const std::string_view>, span<T>, bitmap&) -> std::size_t
+// 	from_str_batch    : (span<const std::string_view>, span<T>, bitmap&) -> std::size_t
+// -----------------------------------------------------------------------------
+	/*
+		Converts a column of fields at once, ex. one column of a loaded csv.
+		Malformed fields do not throw. valid is resized to strs.size()
+		and bit i is set if and only if strs[i] is converted into out[i].
+		out[i] of a malformed field is untouched.
+		Returns the number of converted fields.
+		out must be at least as long as strs.
+
+		Numbers are converted by a columnar kernel, which converts digits of
+		plain decimals two fields at a time with SIMD instructions when they are enabled.
+		Results are identical to util::try_from_string.
+		Other types are converted field by field by try_apply of from_string_trait,
+		or by try_apply_batch if the trait provides
+			static std::size_t try_apply_batch(span<const std::string_view>, span<T>, util::bitmap&);
+
+		ex)
+			std::vector<std::string_view> fields = {"1.5", "x", "-2"};
+			std::vector<double> values(fields.size());
+			qsb::util::bitmap valid;
+			qsb::util::from_string_batch<double>(fields, values, valid);	// 2
+			valid.test(1);	// false
+	*/
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	std::size_t from_string_batch(span<const std::string_view> strs, span<T> out, bitmap& valid)
+	{
+		if (out.size() < strs.size()) {
+			throw std::invalid_argument("output span is shorter than input span");
+		}
+		using from_string = traits::from_string_trait<T>;
+		valid.assign(strs.size(), false);
+		return from_str_detail::try_apply_batch_trait<from_string>(strs, out.first(strs.size()), valid);
+	}
+
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	std::size_t from_str_batch(span<const std::string_view> strs, span<T> out, bitmap& valid)
+	{
+		return util::from_string_batch<T>(strs, out, valid);
+	}
+
 // -----------------------------------------------------------------------------
 //	convertible_string
 // -----------------------------------------------------------------------------
+	template <typename T>
+	class cached_convertible_string;
+
 	/*
 		This class has two roles.
 			1. facade to util::from_string, util::safe_from_string and util::try_from_string
@@ -182,8 +353,140 @@ namespace qsb { namespace util {
 	// -------------------------------------------------------------------------
 	//  cast
 	//
-		template <typename T>
-		T as() const { return util::from_str<T>(this->str()); }
+		template <typename U>
+		constexpr U as() const { return util::from_str<U>(this->str()); }
+
+		constexpr auto as_int() const -> int { return this->as<int>(); }
+		constexpr auto as_long() const -> long { return this->as<long>(); }
+		constexpr auto as_llong() const -> long long { return this->as<long long>(); }
+		constexpr auto as_float() const -> float { return this->as<float>(); }
+		constexpr auto as_double() const -> double { return this->as<double>(); }
+		constexpr auto as_ldouble() const -> long double { return this->as<long double>(); }
+
+		template <typename U>
+		constexpr optional<U> maybe() const { return util::safe_from_str<U>(this->str()); }
+
+		constexpr auto maybe_int() const -> optional<int> { return this->maybe<int>(); }
+		constexpr auto maybe_long() const -> optional<long> { return this->maybe<long>(); }
+		constexpr auto maybe_llong() const -> optional<long long> { return this->maybe<long long>(); }
+		constexpr auto maybe_float() const -> optional<float> { return this->maybe<float>(); }
+		constexpr auto maybe_double() const -> optional<double> { return this->maybe<double>(); }
+		constexpr auto maybe_ldouble() const -> optional<long double> { return this->maybe<long double>(); }
+
+		template <typename U>
+		constexpr void set_into(U& ref) const { util::from_str(str_, ref); }
+
+		template <typename U>
+		constexpr bool try_set_into(U& ref) const { return util::try_from_string(str_, ref); }
+
+	// -------------------------------------------------------------------------
+	//  cache
+	//
+		cached_convertible_string<T> cached() const& { return cached_convertible_string<T>(str_); }
+		cached_convertible_string<T> cached() && { return cached_convertible_string<T>(std::move(str_)); }
+
+	// -------------------------------------------------------------------------
+	//  implicit cast
+	//
+		template <typename U, std::enable_if_t<
+			!from_str_detail::is_optional<U>::value,
+		std::nullptr_t> = nullptr>
+		constexpr operator U() const
+		{
+			return this->as<U>();
+		}
+
+		template <typename U, std::enable_if_t<
+			from_str_detail::is_optional<U>::value &&
+			!std::is_reference_v<typename from_str_detail::remove_cvref_t<U>::value_type>,
+		std::nullptr_t> = nullptr>
+		constexpr operator U() const
+		{
+			return this->maybe<typename from_str_detail::remove_cvref_t<U>::value_type>();
+		}
+
+	private:
+		string_type str_; 
+
+	}; // class convertible_string
+
+// -----------------------------------------------------------------------------
+//	cached_convertible_string
+// -----------------------------------------------------------------------------
+	/*
+		convertible_string which converts the string only once per requested type.
+		convertible_string converts the string on every cast, so a value read
+		as optional<int>, double and std::string is parsed three times.
+		This class memoizes the result (including failure) of the first conversion
+		to each type, and later casts to the type copy the memoized value.
+
+		Thread safety:
+			const member functions, i.e. all casts, may be called concurrently.
+			A cast whose result is memoized takes no lock (see from_str_detail::conversion_cache).
+			Move construction requires exclusive access to the source.
+		Copies start with an empty cache.
+
+		Unlike convertible_string, failures of as and implicit cast are reported
+		by std::invalid_argument rather than the exception of from_string_trait::apply,
+		because the failure is memoized as from_string_errc.
+
+		ex)
+			const auto x = qsb::util::lazy_from_str("42").cached();
+			int i = x;			// parsed
+			int j = x;			// memoized
+			double d = x;		// parsed as double
+	*/
+	template <typename T>
+	class cached_convertible_string {
+	private:
+		using this_type = cached_convertible_string;
+		using string_type = T;
+
+	public:
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		cached_convertible_string() = delete;
+
+		cached_convertible_string(const this_type& other)
+			: str_(other.str_)
+		{
+		}
+
+		cached_convertible_string(this_type&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+			: str_(std::forward<T>(other.str_)), cache_(std::move(other.cache_))
+		{
+		}
+
+		template <typename AT, std::enable_if_t<
+			!std::is_same_v<from_str_detail::remove_cvref_t<AT>, this_type>,
+		std::nullptr_t> = nullptr>
+		explicit cached_convertible_string(AT&& str)
+			: str_(std::forward<AT>(str))
+		{
+		}
+
+	// -------------------------------------------------------------------------
+	//  assignments
+	//
+		this_type& operator =(const this_type&) = delete;
+		this_type& operator =(this_type&&) = delete;
+
+	// -------------------------------------------------------------------------
+	//	get  
+	//
+		const string_type& str() const noexcept { return str_; }
+
+	// -------------------------------------------------------------------------
+	//  cast
+	//
+		template <typename U>
+		U as() const
+		{
+			const auto& entry = this->entry<U>();
+			from_str_detail::throw_if_failed(entry.ec);
+			return *entry.value;
+		}
 
 		auto as_int() const -> int { return this->as<int>(); }
 		auto as_long() const -> long { return this->as<long>(); }
@@ -192,8 +495,8 @@ namespace qsb { namespace util {
 		auto as_double() const -> double { return this->as<double>(); }
 		auto as_ldouble() const -> long double { return this->as<long double>(); }
 
-		template <typename T>
-		optional<T> maybe() const { return util::safe_from_str<T>(this->str()); }
+		template <typename U>
+		optional<U> maybe() const { return this->entry<U>().value; }
 
 		auto maybe_int() const -> optional<int> { return this->maybe<int>(); }
 		auto maybe_long() const -> optional<long> { return this->maybe<long>(); }
@@ -202,81 +505,185 @@ namespace qsb { namespace util {
 		auto maybe_double() const -> optional<double> { return this->maybe<double>(); }
 		auto maybe_ldouble() const -> optional<long double> { return this->maybe<long double>(); }
 
-		template <typename T>
-		constexpr void set_into(T& ref) const { util::from_str(str_, ref); }
+		template <typename U>
+		void set_into(U& ref) const { ref = this->as<U>(); }
 
-		template <typename T>
-		constexpr bool try_set_into(T& ref) const { return util::try_from_string(str_, ref); }
+		template <typename U>
+		bool try_set_into(U& ref) const
+		{
+			const auto& entry = this->entry<U>();
+			if (entry.ec != traits::from_string_errc::ok) {
+				return false;
+			}
+			ref = *entry.value;
+			return true;
+		}
 
 	// -------------------------------------------------------------------------
 	//  implicit cast
 	//
-		template <typename T, std::enable_if_t<
-			!from_str_detail::is_optional<T>::value,
+		template <typename U, std::enable_if_t<
+			!from_str_detail::is_optional<U>::value,
 		std::nullptr_t> = nullptr>
-		operator T() const
+		operator U() const
 		{
-			return this->as<T>();
+			return this->as<U>();
 		}
 
-		template <typename T, std::enable_if_t<
-			from_str_detail::is_optional<T>::value &&
-			!std::is_reference_v<typename from_str_detail::remove_cvref_t<T>::value_type>,
+		template <typename U, std::enable_if_t<
+			from_str_detail::is_optional<U>::value &&
+			!std::is_reference_v<typename from_str_detail::remove_cvref_t<U>::value_type>,
 		std::nullptr_t> = nullptr>
-		operator T() const
+		operator U() const
 		{
-			return this->maybe<typename from_str_detail::remove_cvref_t<T>::value_type>();
+			return this->maybe<typename from_str_detail::remove_cvref_t<U>::value_type>();
 		}
 
 	private:
-		string_type str_; 
+		template <typename U>
+		const from_str_detail::conversion_cache_entry<U>& entry() const
+		{
+			return cache_.get_or_convert<U>([this](optional<U>& out) {
+				using from_string = traits::from_string_trait<U>;
+				if constexpr (std::is_default_constructible_v<U>) {
+					U value {};
+					const auto ec = from_str_detail::try_apply_trait<from_string>(this->view(), value);
+					if (ec == traits::from_string_errc::ok) {
+						out = std::move(value);
+					}
+					return ec;
+				}
+				else {
+					return from_str_detail::try_apply_trait<from_string>(this->view(), out);
+				}
+			});
+		}
 
-	}; // class convertible_string
+		// const char* is passed as is to avoid strlen. the others are viewed without copy
+		auto view() const noexcept
+		{
+			if constexpr (std::is_convertible_v<const string_type&, const char*>) {
+				return static_cast<const char*>(str_);
+			}
+			else {
+				return std::string_view(str_);
+			}
+		}
+
+	private:
+		string_type str_;
+		from_str_detail::conversion_cache cache_;
+
+	}; // class cached_convertible_string
 
 // -----------------------------------------------------------------------------
 //  lazy_from_string : <string> -> convertible_string<string>
 // 	lazy_from_str	 : <string> -> convertible_string<string>
 // -----------------------------------------------------------------------------
-	convertible_string<const char*> lazy_from_string(const char* str)
+	/*
+		std::string_view version does not copy the string.
+		The viewed buffer must outlive the returned convertible_string.
+	*/
+	constexpr convertible_string<const char*> lazy_from_string(const char* str)
 	{
 		return convertible_string<const char*>(str);
 	}
-	convertible_string<std::string> lazy_from_string(const std::string& str)
+	constexpr convertible_string<std::string_view> lazy_from_string(std::string_view str)
+	{
+		return convertible_string<std::string_view>(str);
+	}
+	inline convertible_string<std::string> lazy_from_string(const std::string& str)
 	{
 		return convertible_string<std::string>(str);
 	}
-	convertible_string<std::string> lazy_from_string(std::string&& str)
+	inline convertible_string<std::string> lazy_from_string(std::string&& str)
 	{
 		return convertible_string<std::string>(std::move(str));
 	}
-	convertible_string<const std::string&> lazy_from_string(std::reference_wrapper<std::string> str)
+	inline convertible_string<const std::string&> lazy_from_string(std::reference_wrapper<std::string> str)
 	{
 		return convertible_string<const std::string&>(str);
 	}
-	convertible_string<const std::string&> lazy_from_string(std::reference_wrapper<const std::string> str)
+	inline convertible_string<const std::string&> lazy_from_string(std::reference_wrapper<const std::string> str)
 	{
 		return convertible_string<const std::string&>(str);
 	}
 
-	convertible_string<const char*> lazy_from_str(const char* str)
+	constexpr convertible_string<const char*> lazy_from_str(const char* str)
+	{
+		return lazy_from_string(str);
+	}
+	constexpr convertible_string<std::string_view> lazy_from_str(std::string_view str)
 	{
 		return lazy_from_string(str);
 	}
-	convertible_string<std::string> lazy_from_str(const std::string& str)
+	inline convertible_string<std::string> lazy_from_str(const std::string& str)
 	{
 		return lazy_from_string(str);
 	}
-	convertible_string<std::string> lazy_from_str(std::string&& str)
+	inline convertible_string<std::string> lazy_from_str(std::string&& str)
 	{
 		return lazy_from_string(std::move(str));
 	}
-	convertible_string<const std::string&> lazy_from_str(std::reference_wrapper<std::string> str)
+	inline convertible_string<const std::string&> lazy_from_str(std::reference_wrapper<std::string> str)
 	{
 		return lazy_from_string(str);
 	}
-	convertible_string<const std::string&> lazy_from_str(std::reference_wrapper<const std::string> str)
+	inline convertible_string<const std::string&> lazy_from_str(std::reference_wrapper<const std::string> str)
 	{
 		return lazy_from_string(str);
 	}
 
+// -----------------------------------------------------------------------------
+//  constant_from_string : std::string_view -> T
+// 	constant_from_str	 : std::string_view -> T
+// -----------------------------------------------------------------------------
+	/*
+		Conversion which is always done at compile time (consteval),
+		so a malformed literal is a compile error, not a runtime exception.
+		Before C++20 this is constexpr, and the result must be used
+		in a constant expression to force compile time conversion.
+
+		ex)
+			constexpr auto threshold = qsb::util::constant_from_str<double>("1e-8");
+	*/
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	QSB_CONSTEVAL T constant_from_string(std::string_view str)
+	{
+		return util::from_string<T>(str);
+	}
+
+	template <typename T, std::enable_if_t<
+		from_str_detail::string_appliable<traits::from_string_trait<T>>::value,
+	std::nullptr_t> = nullptr>
+	QSB_CONSTEVAL T constant_from_str(std::string_view str)
+	{
+		return util::from_string<T>(str);
+	}
+
 }} // namespace qsb::util
+
+namespace qsb {
+// -----------------------------------------------------------------------------
+//  literals
+// -----------------------------------------------------------------------------
+	/*
+		"42"_from_str is a convertible_string viewing the literal.
+		Casts in constant expressions are done at compile time.
+
+		ex)
+			using namespace qsb::literals;
+			constexpr int i = "42"_from_str;
+			constexpr double d = "0.5"_from_str;
+	*/
+	namespace literals {
+		constexpr util::convertible_string<std::string_view> operator ""_from_str(const char* str, std::size_t size) noexcept
+		{
+			return util::convertible_string<std::string_view>(std::string_view(str, size));
+		}
+
+	} // namespace literals
+
+} // namespace qsb
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 #include <utility>
 #include "../../_external/TartanLlama_optional/optional.hpp"
+#include "to_str.h"
 
 namespace qsb { namespace opt_detail {
 // -----------------------------------------------------------------------------
@@ -66,7 +69,213 @@ namespace qsb {
 // -----------------------------------------------------------------------------
 	struct in_place_t {};
 	constexpr in_place_t in_place;
-	
+
+} // namespace qsb
+
+namespace qsb { namespace traits {
+// -----------------------------------------------------------------------------
+//  optional_niche
+// -----------------------------------------------------------------------------
+	/*
+		traits::optional_niche is a customization point to store qsb::optional<T> without a flag.
+		A specialization reserves one value of T, a niche, which represents nullopt.
+			static T empty_value() noexcept;				// the niche
+			static bool is_empty(const T& value) noexcept;	// true if value is the niche
+		With a niche, sizeof(optional<T>) == sizeof(T),
+		and optional<T> is trivially copyable and literal if T is.
+		Both functions are constexpr so that optional<T> is usable in constant expressions.
+
+		Specializations are provided for double and float, whose niche is a quiet NaN
+		with a reserved payload. NaNs made by arithmetic differ from it and are values.
+		traits::sentinel_niche<T, Sentinel> is a helper for integers, enums and pointers.
+		Pointers have no niche by default, since optional<T*>(nullptr) has a value.
+		ex)
+			enum class quote_id : std::int32_t {};
+
+			template <>
+			struct qsb::traits::optional_niche<quote_id>
+				: qsb::traits::sentinel_niche<quote_id, quote_id{ -1 }> {};
+
+			static_assert(sizeof(qsb::optional<quote_id>) == sizeof(quote_id));
+
+			template <>
+			struct qsb::traits::optional_niche<const quote*>
+				: qsb::traits::sentinel_niche<const quote*, nullptr> {};	// optional<const quote*>(nullptr) has no value
+	*/
+	template <typename T, typename = void>
+	struct optional_niche {};
+
+	template <typename T, T Sentinel>
+	struct sentinel_niche {
+		static constexpr T empty_value() noexcept { return Sentinel; }
+		static constexpr bool is_empty(const T& value) noexcept { return value == Sentinel; }
+	};
+
+// -----------------------------------------------------------------------------
+//  optional_niche<floating point>
+// -----------------------------------------------------------------------------
+	/*
+		std::bit_cast is C++20, but msvc, gcc and clang provide the builtin
+		also in C++17 mode, which is usable in constant expressions unlike std::memcpy.
+	*/
+	template <typename T, typename Bits, Bits Payload>
+	struct nan_payload_niche {
+		static_assert(sizeof(T) == sizeof(Bits), "size of bits must be that of the floating point type.");
+
+		static constexpr T empty_value() noexcept
+		{
+			return __builtin_bit_cast(T, Payload);
+		}
+
+		static constexpr bool is_empty(const T& value) noexcept
+		{
+			return __builtin_bit_cast(Bits, value) == Payload;
+		}
+	};
+
+	template <>
+	struct optional_niche<double> : nan_payload_niche<double, std::uint64_t, 0x7FF8000000EA17E5ull> {};
+
+	template <>
+	struct optional_niche<float> : nan_payload_niche<float, std::uint32_t, 0x7FC0EA17u> {};
+
+}} // namespace qsb::traits
+
+namespace qsb { namespace opt_detail {
+// -----------------------------------------------------------------------------
+//  has_niche
+// -----------------------------------------------------------------------------
+	auto has_niche_impl(...) -> std::false_type;
+
+	template <typename Niche, typename T>
+	auto has_niche_impl(Niche, T&&) -> decltype(
+		Niche::empty_value(), std::enable_if_t<std::is_same_v<decltype(Niche::is_empty(std::declval<T>())), bool>>(), std::true_type{});
+
+	template <typename T>
+	using has_niche = decltype(has_niche_impl(std::declval<traits::optional_niche<T>>(), std::declval<const T&>()));
+
+// -----------------------------------------------------------------------------
+//  niche_storage
+// -----------------------------------------------------------------------------
+	/*
+		Internal storage of optional<T> for T with a niche, which holds only T.
+		The interface is the subset of tl::optional used by qsb::optional.
+	*/
+	template <typename T>
+	class niche_storage {
+	private:
+		using this_type = niche_storage;
+		using niche = traits::optional_niche<T>;
+
+	public:
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		constexpr niche_storage() noexcept : value_(niche::empty_value()) {}
+		constexpr niche_storage(tl::nullopt_t) noexcept : value_(niche::empty_value()) {}
+
+		template <typename ...Args>
+		explicit constexpr niche_storage(tl::in_place_t, Args&&... args) : value_(std::forward<Args>(args)...) {}
+
+		template <typename U, std::enable_if_t<
+			std::is_constructible_v<T, U&&> && !std::is_same_v<std::decay_t<U>, this_type> && !std::is_same_v<std::decay_t<U>, tl::in_place_t>,
+			std::nullptr_t
+		> = nullptr>
+		constexpr niche_storage(U&& value) : value_(std::forward<U>(value)) {}
+
+	// -------------------------------------------------------------------------
+	//  assignments
+	//
+		constexpr this_type& operator =(tl::nullopt_t) noexcept
+		{
+			reset();
+			return *this;
+		}
+
+		template <typename U, std::enable_if_t<
+			std::is_assignable_v<T&, U&&> && !std::is_same_v<std::decay_t<U>, this_type>,
+			std::nullptr_t
+		> = nullptr>
+		constexpr this_type& operator =(U&& value)
+		{
+			value_ = std::forward<U>(value);
+			return *this;
+		}
+
+	// -------------------------------------------------------------------------
+	//  get
+	//
+		constexpr T* operator->() noexcept { return &value_; }
+		constexpr const T* operator->() const noexcept { return &value_; }
+		constexpr T& operator *() & noexcept { return value_; }
+		constexpr const T& operator *() const & noexcept { return value_; }
+		constexpr T&& operator *() && noexcept { return std::move(value_); }
+		constexpr const T&& operator *() const && noexcept { return std::move(value_); }
+
+		constexpr bool has_value() const noexcept { return !niche::is_empty(value_); }
+		explicit constexpr operator bool() const noexcept { return has_value(); }
+
+		constexpr T& value() & { return this_type::throw_if_empty(*this).value_; }
+		constexpr const T& value() const & { return this_type::throw_if_empty(*this).value_; }
+		constexpr T&& value() && { return std::move(this_type::throw_if_empty(*this).value_); }
+		constexpr const T&& value() const && { return std::move(this_type::throw_if_empty(*this).value_); }
+
+		template <typename U>
+		constexpr T value_or(U&& dvalue) const &
+		{
+			return has_value() ? value_ : static_cast<T>(std::forward<U>(dvalue));
+		}
+
+		template <typename U>
+		constexpr T value_or(U&& dvalue) &&
+		{
+			return has_value() ? std::move(value_) : static_cast<T>(std::forward<U>(dvalue));
+		}
+
+	// -------------------------------------------------------------------------
+	//  update
+	//
+		void swap(this_type& other) noexcept(std::is_nothrow_swappable_v<T>)
+		{
+			using std::swap;
+			swap(value_, other.value_);
+		}
+
+		constexpr void reset() noexcept
+		{
+			value_ = niche::empty_value();
+		}
+
+		template <typename ...Args>
+		constexpr T& emplace(Args&& ...args)
+		{
+			value_ = T(std::forward<Args>(args)...);
+			return value_;
+		}
+
+	private:
+		template <typename Self>
+		static constexpr Self& throw_if_empty(Self& self)
+		{
+			if (!self.has_value()) {
+				throw tl::bad_optional_access();
+			}
+			return self;
+		}
+
+		T value_;
+
+	}; // class niche_storage
+
+// -----------------------------------------------------------------------------
+//  optional_storage_t
+// -----------------------------------------------------------------------------
+	template <typename T>
+	using optional_storage_t = std::conditional_t<has_niche<T>::value, niche_storage<T>, tl::optional<T>>;
+
+}} // namespace qsb::opt_detail
+
+namespace qsb {
 // -----------------------------------------------------------------------------
 //  optional
 // -----------------------------------------------------------------------------
@@ -78,6 +287,9 @@ namespace qsb {
 	* (Instead of using tl::optional directly, we wrap it to reduce dependency on external library)
 	* https://github.com/TartanLlama/optional/tree/v1.0.0
 	* 
+	* Types with traits::optional_niche, such as double, are stored without tl::optional
+	* and a flag, so that optional<double> is as large as double. See traits::optional_niche.
+	* 
 	* With introducing C++17, we can replace tl::optional with std::optional.
 	* (Some utilities of tl, such as tl::detail::invoke_result_t, are also used.
 	*  These can be replaced with STL ones after introducing C++17, too.)
@@ -116,12 +328,21 @@ namespace qsb {
 	*		| make_smaller
 	*		| add_rainbow
 	*		/= default_cute_cat_img;  // assign(=) computed result, or(/) default_cute_cat_img
+	* 
+	* Each stage of the pipe makes an intermediate optional. opt_helpers::lazy fuses
+	* the stages into one function, which is called once at the terminal /=, value() or eval()
+	* after one presence check. Results are the same as those of the eager pipe.
+	* ---------------------------------------------------------------------------
+	*	const image at_lease_cute_cat = opt_helpers::lazy(crop_to_cat(img))
+	*		| add_bow_tie
+	*		| make_smaller
+	*		/= default_cute_cat_img;
 	*/
 	template <typename T>
 	class optional {
 	private:
 		using this_type = optional;
-		using internal_type = tl::optional<T>;		
+		using internal_type = opt_detail::optional_storage_t<T>;
 		template <typename U> friend class optional;
 
 	public:
@@ -139,20 +360,30 @@ namespace qsb {
 			typename U,
 			std::enable_if_t<std::is_constructible_v<tl::optional<T>, const tl::optional<U>&>, std::nullptr_t> = nullptr
 		>
-		explicit optional(const optional<U>& other) : internal_(other.internal_) {}
+		explicit optional(const optional<U>& other)
+		{
+			if (other.has_value()) {
+				internal_.emplace(*other);
+			}
+		}
 
 		template <
 			typename U,
 			std::enable_if_t<std::is_constructible_v<tl::optional<T>, tl::optional<U>&&>, std::nullptr_t> = nullptr
 		>
-		explicit optional(optional<U>&& other) : internal_(other.internal_) {}
+		explicit optional(optional<U>&& other)
+		{
+			if (other.has_value()) {
+				internal_.emplace(*std::move(other));
+			}
+		}
 
 		template <
 			typename ...Args,
-			std::enable_if_t<std::is_constructible_v<tl::optional<T>, Args&&...>, std::nullptr_t> = nullptr
+			std::enable_if_t<std::is_constructible_v<T, Args&&...>, std::nullptr_t> = nullptr
 		>
 		explicit constexpr optional(in_place_t, Args&&... args)
-			: internal_(in_place, std::forward<Args>(args)...) {}
+			: internal_(tl::in_place, std::forward<Args>(args)...) {}
 
 		template <
 			typename U = T,
@@ -184,17 +415,27 @@ namespace qsb {
 
 		template <typename U>
 		auto operator =(const optional<U>& other)
-			-> std::enable_if_t<std::is_assignable_v<internal_type&, const optional<U>&>, this_type&>
+			-> std::enable_if_t<std::is_assignable_v<tl::optional<T>&, const tl::optional<U>&>, this_type&>
 		{
-			internal_ = other.internal_;
+			if (other.has_value()) {
+				internal_ = *other;
+			}
+			else {
+				internal_ = tl::nullopt;
+			}
 			return *this;
 		}
 
 		template <typename U>
 		auto operator =(optional<U>&& other)
-			-> std::enable_if_t<std::is_assignable_v<internal_type&, optional<U>&&>, this_type&>
+			-> std::enable_if_t<std::is_assignable_v<tl::optional<T>&, tl::optional<U>&&>, this_type&>
 		{
-			internal_ = std::move(other).internal_;
+			if (other.has_value()) {
+				internal_ = *std::move(other);
+			}
+			else {
+				internal_ = tl::nullopt;
+			}
 			return *this;
 		}
 
@@ -265,17 +506,18 @@ namespace qsb {
 			return internal_.value_or(std::forward<U>(dvalue));
 		}
 
+		// tl::optional::value_or && copies the value, so it is not delegated
 		template <typename U>
 		constexpr T value_or(U&& dvalue)&&
 		{
-			return std::move(internal_).value_or(std::forward<U>(dvalue));
+			return has_value() ? *std::move(internal_) : static_cast<T>(std::forward<U>(dvalue));
 		}
 
 	// -------------------------------------------------------------------------
 	//  monadic
 	//
 		template <typename F>
-		constexpr auto and_then(F&& f) & -> tl::detail::invoke_result_t<F, const T&>
+		constexpr auto and_then(F&& f) & -> tl::detail::invoke_result_t<F, T&>
 		{
 			using result = tl::detail::invoke_result_t<F, T&>;
 			static_assert(opt_detail::is_optional<std::remove_cv_t<std::remove_reference_t<result>>>::value,
@@ -585,6 +827,215 @@ namespace qsb { namespace opt_detail {
 
 }} // namespace qsb::opt_detail
 
+namespace qsb { namespace opt_detail {
+// -----------------------------------------------------------------------------
+//  identity_stage
+// -----------------------------------------------------------------------------
+	struct identity_stage {
+		template <typename X>
+		constexpr X&& operator()(X&& x) const noexcept
+		{
+			return std::forward<X>(x);
+		}
+	};
+
+// -----------------------------------------------------------------------------
+//  composed_stage
+// -----------------------------------------------------------------------------
+	/*
+		g after f. If f returns a plain value, g is called with it directly,
+		so that consecutive transforms do not materialize optionals in between.
+		If f returns an optional (and_then), g is dispatched on it as operator | does.
+	*/
+	template <typename F, typename G>
+	struct composed_stage {
+		F f;
+		G g;
+
+		template <typename X>
+		constexpr decltype(auto) operator()(X&& x)
+		{
+			using middle = tl::detail::invoke_result_t<F&, X&&>;
+			if constexpr (is_optional<std::remove_cv_t<std::remove_reference_t<middle>>>::value) {
+				return tl::detail::invoke(f, std::forward<X>(x)) | g;
+			}
+			else {
+				return tl::detail::invoke(g, tl::detail::invoke(f, std::forward<X>(x)));
+			}
+		}
+	};
+
+// -----------------------------------------------------------------------------
+//  lazy_pipeline
+// -----------------------------------------------------------------------------
+	/*
+		Expression of opt_helpers::lazy(opt) | f | g ..., which composes stages
+		without evaluation and evaluates them once at the terminal with one presence check.
+		Source is a reference to the optional, which is valid until the end of the full expression.
+
+		Terminals are
+			/= dvalue		: the value or dvalue
+			value()			: the value, or throws tl::bad_optional_access
+			eval() and conversion to optional
+		A nullary function (or_else) evaluates the pipeline and continues eagerly.
+	*/
+	template <typename Source, typename Stage>
+	class lazy_pipeline {
+	private:
+		using this_type = lazy_pipeline;
+		using source_reference = decltype(*std::declval<Source&&>());
+		using stage_result = tl::detail::invoke_result_t<Stage&, source_reference>;
+		using stage_result_type = std::remove_cv_t<std::remove_reference_t<stage_result>>;
+		static constexpr bool returns_optional = is_optional<stage_result_type>::value;
+		template <typename S, typename St> friend class lazy_pipeline;
+
+	public:
+		using result_type = std::conditional_t<returns_optional, stage_result_type, optional<stage_result_type>>;
+		using value_type = typename result_type::value_type;
+
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		template <typename S, typename St>
+		constexpr lazy_pipeline(S&& source, St&& stage)
+			: source_(std::forward<S>(source)), stage_(std::forward<St>(stage))
+		{
+		}
+
+	// -------------------------------------------------------------------------
+	//  compose
+	//
+		template <typename G, std::enable_if_t<!std::is_invocable_v<G&>, std::nullptr_t> = nullptr>
+		friend constexpr auto operator |(this_type&& self, G&& g)
+		{
+			using stage_type = composed_stage<Stage, std::decay_t<G>>;
+			return lazy_pipeline<Source, stage_type>(
+				static_cast<Source&&>(self.source_), stage_type{ std::move(self.stage_), std::forward<G>(g) });
+		}
+
+		template <typename G, std::enable_if_t<std::is_invocable_v<G&>, std::nullptr_t> = nullptr>
+		friend constexpr auto operator |(this_type&& self, G&& g)
+		{
+			return std::move(self).eval() | std::forward<G>(g);
+		}
+
+	// -------------------------------------------------------------------------
+	//  terminals
+	//
+		constexpr result_type eval() &&
+		{
+			if (!source_.has_value()) {
+				return result_type(nullopt);
+			}
+			if constexpr (returns_optional) {
+				return tl::detail::invoke(stage_, this->source_value());
+			}
+			else {
+				return result_type(tl::detail::invoke(stage_, this->source_value()));
+			}
+		}
+
+		constexpr operator result_type() &&
+		{
+			return std::move(*this).eval();
+		}
+
+		constexpr value_type value() &&
+		{
+			if (!source_.has_value()) {
+				throw tl::bad_optional_access();
+			}
+			if constexpr (returns_optional) {
+				return tl::detail::invoke(stage_, this->source_value()).value();
+			}
+			else {
+				return tl::detail::invoke(stage_, this->source_value());
+			}
+		}
+
+		template <typename U>
+		friend constexpr value_type operator /=(this_type&& self, U&& dvalue)
+		{
+			if (!self.source_.has_value()) {
+				return static_cast<value_type>(std::forward<U>(dvalue));
+			}
+			if constexpr (returns_optional) {
+				return tl::detail::invoke(self.stage_, self.source_value()) /= std::forward<U>(dvalue);
+			}
+			else {
+				return tl::detail::invoke(self.stage_, self.source_value());
+			}
+		}
+
+	private:
+		constexpr source_reference source_value()
+		{
+			return *static_cast<Source&&>(source_);
+		}
+
+	private:
+		Source source_;
+		Stage stage_;
+
+	}; // class lazy_pipeline
+
+}} // namespace qsb::opt_detail
+
+namespace qsb { namespace opt_helpers {
+// -----------------------------------------------------------------------------
+//  lazy
+// -----------------------------------------------------------------------------
+	/*
+		Opt-in lazy version of the pipe operator of optional.
+			opt | f | g /= dvalue					// eager. an optional per stage
+			opt_helpers::lazy(opt) | f | g /= dvalue	// f and g are fused and called once
+		Stages are dispatched as operator | does, and the results are the same.
+		The source is referred, not copied, so the pipeline must be consumed
+		within the full expression, as in the examples.
+	*/
+	template <typename T>
+	constexpr auto lazy(optional<T>& opt)
+	{
+		return opt_detail::lazy_pipeline<optional<T>&, opt_detail::identity_stage>(opt, opt_detail::identity_stage{});
+	}
+
+	template <typename T>
+	constexpr auto lazy(const optional<T>& opt)
+	{
+		return opt_detail::lazy_pipeline<const optional<T>&, opt_detail::identity_stage>(opt, opt_detail::identity_stage{});
+	}
+
+	template <typename T>
+	constexpr auto lazy(optional<T>&& opt)
+	{
+		return opt_detail::lazy_pipeline<optional<T>&&, opt_detail::identity_stage>(std::move(opt), opt_detail::identity_stage{});
+	}
+
+}} // namespace qsb::opt_helpers
+
+namespace qsb { namespace traits {
+// -----------------------------------------------------------------------------
+//  write_string_trait<optional>
+// -----------------------------------------------------------------------------
+	// the value, or nothing for nullopt
+	template <typename T>
+	struct write_string_trait<optional<T>> {
+		template <typename Sink>
+		static void write(Sink& sink, const optional<T>& value)
+		{
+			if (value.has_value()) {
+				to_str_detail::write_value(sink, *value);
+			}
+		}
+
+		static std::size_t estimate_size(const optional<T>& value) noexcept
+		{
+			return value.has_value() ? to_str_detail::estimate_value_size(*value) : 0;
+		}
+	};
+
+}} // namespace qsb::traits
+
 namespace std {
 // -----------------------------------------------------------------------------
 //  hash
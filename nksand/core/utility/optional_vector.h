@@ -0,0 +1,519 @@
+#pragma once
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../ranges.h"
+#include "bitmap.h"
+#include "optional.h"
+#include "detail/bit.h"
+
+namespace qsb { namespace opt_detail {
+// -----------------------------------------------------------------------------
+//  validity_bits
+// -----------------------------------------------------------------------------
+	// count bits of the bitmap starting at bit offset, where count <= 64
+	inline util::bitmap::word_type validity_bits(const util::bitmap& valid, std::size_t offset, std::size_t count) noexcept
+	{
+		using word_type = util::bitmap::word_type;
+		constexpr std::size_t word_bits = util::bitmap::word_bits;
+
+		const std::size_t index = offset / word_bits;
+		const std::size_t shift = offset % word_bits;
+		word_type word = valid.word(index) >> shift;
+		if (shift != 0 && shift + count > word_bits) {
+			word |= valid.word(index + 1) << (word_bits - shift);
+		}
+		return count == word_bits ? word : word & ~(~word_type(0) << count);
+	}
+
+// -----------------------------------------------------------------------------
+//  optional_reference
+// -----------------------------------------------------------------------------
+	/*
+		Proxy of an element of optional_vector and optional_span,
+		which behaves like optional<T>& for assignments and reads.
+	*/
+	template <typename T>
+	class optional_reference {
+	private:
+		using this_type = optional_reference;
+
+	public:
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		optional_reference(T* value, util::bitmap* valid, std::size_t pos) noexcept
+			: value_(value), valid_(valid), pos_(pos)
+		{
+		}
+
+	// -------------------------------------------------------------------------
+	//  assignments
+	//
+		const this_type& operator =(nullopt_t) const noexcept
+		{
+			valid_->reset(pos_);
+			return *this;
+		}
+
+		const this_type& operator =(const T& value) const
+		{
+			*value_ = value;
+			valid_->set(pos_);
+			return *this;
+		}
+
+		const this_type& operator =(T&& value) const
+		{
+			*value_ = std::move(value);
+			valid_->set(pos_);
+			return *this;
+		}
+
+		const this_type& operator =(const optional<T>& value) const
+		{
+			return value.has_value() ? (*this = *value) : (*this = nullopt);
+		}
+
+		const this_type& operator =(const this_type& other) const
+		{
+			return *this = static_cast<optional<T>>(other);
+		}
+
+	// -------------------------------------------------------------------------
+	//  get
+	//
+		bool has_value() const noexcept { return valid_->test(pos_); }
+		explicit operator bool() const noexcept { return this->has_value(); }
+
+		T& operator *() const noexcept { return *value_; }
+		T* operator->() const noexcept { return value_; }
+
+		T& value() const
+		{
+			if (!this->has_value()) {
+				throw tl::bad_optional_access();
+			}
+			return *value_;
+		}
+
+		template <typename U>
+		T value_or(U&& dvalue) const
+		{
+			return this->has_value() ? *value_ : static_cast<T>(std::forward<U>(dvalue));
+		}
+
+		operator optional<T>() const
+		{
+			return this->has_value() ? optional<T>(*value_) : optional<T>(nullopt);
+		}
+
+	private:
+		T* value_;
+		util::bitmap* valid_;
+		std::size_t pos_;
+
+	}; // class optional_reference
+
+}} // namespace qsb::opt_detail
+
+namespace qsb {
+	template <typename T>
+	class optional_vector;
+
+// -----------------------------------------------------------------------------
+//  optional_span
+// -----------------------------------------------------------------------------
+	/*
+		View of a sequence of optional<T> stored as a contiguous array of values
+		and a validity bitmap, i.e. the columnar layout of optional_vector.
+		Values of invalid elements are unspecified.
+
+		Element access returns optional<T> for optional_span<const T>,
+		and a proxy assignable from T, optional<T> and nullopt for optional_span<T>.
+
+		Bulk operations follow the optional API and return optional_vector.
+		They proceed 64 elements at a time, and a block whose elements are all valid
+		is processed by a plain loop over the values, which compilers can vectorize.
+			transform(f) : f(value) for valid elements
+			and_then(f)	 : f(value) -> optional<U> for valid elements
+			value_or(d)	 : std::vector<T> where invalid elements are d (also operator /=)
+	*/
+	template <typename T>
+	class optional_span {
+	private:
+		using this_type = optional_span;
+		using value_type_ = std::remove_const_t<T>;
+		using bitmap_pointer = std::conditional_t<std::is_const_v<T>, const util::bitmap*, util::bitmap*>;
+		using word_type = util::bitmap::word_type;
+		static constexpr std::size_t word_bits = util::bitmap::word_bits;
+
+	public:
+		using value_type = value_type_;
+		using reference = std::conditional_t<std::is_const_v<T>, optional<value_type>, opt_detail::optional_reference<value_type>>;
+
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		constexpr optional_span() noexcept = default;
+
+		// valid must have at least offset + values.size() bits
+		optional_span(span<T> values, bitmap_pointer valid, std::size_t offset = 0) noexcept
+			: values_(values), valid_(valid), offset_(offset)
+		{
+		}
+
+		template <typename U, std::enable_if_t<
+			std::is_const_v<T> && std::is_same_v<U, value_type>, std::nullptr_t
+		> = nullptr>
+		optional_span(const optional_span<U>& other) noexcept
+			: values_(other.values()), valid_(&other.validity()), offset_(other.offset())
+		{
+		}
+
+	// -------------------------------------------------------------------------
+	//  get
+	//
+		std::size_t size() const noexcept { return values_.size(); }
+		bool empty() const noexcept { return values_.empty(); }
+
+		span<T> values() const noexcept { return values_; }
+		const util::bitmap& validity() const noexcept { return *valid_; }
+		std::size_t offset() const noexcept { return offset_; }
+
+		bool has_value(std::size_t i) const noexcept
+		{
+			return valid_->test(offset_ + i);
+		}
+
+		reference operator [](std::size_t i) const
+		{
+			if constexpr (std::is_const_v<T>) {
+				return this->has_value(i) ? optional<value_type>(values_[i]) : optional<value_type>(nullopt);
+			}
+			else {
+				return reference(&values_[i], valid_, offset_ + i);
+			}
+		}
+
+		std::size_t count() const noexcept
+		{
+			std::size_t result = 0;
+			for (std::size_t head = 0; head < this->size(); head += word_bits) {
+				word_type mask = this->block_mask(head);
+				for (; mask != 0; mask &= mask - 1) {
+					++result;
+				}
+			}
+			return result;
+		}
+
+		this_type subspan(std::size_t offset, std::size_t count) const noexcept
+		{
+			return this_type(values_.subspan(offset, count), valid_, offset_ + offset);
+		}
+
+	// -------------------------------------------------------------------------
+	//  bulk operations
+	//
+		template <typename F>
+		auto transform(F&& f) const -> optional_vector<std::decay_t<tl::detail::invoke_result_t<F&, const value_type&>>>
+		{
+			using result_type = std::decay_t<tl::detail::invoke_result_t<F&, const value_type&>>;
+			optional_vector<result_type> result(this->size());
+			result_type* const out = result.values().data();
+			const T* const in = values_.data();
+			for (std::size_t head = 0; head < this->size(); head += word_bits) {
+				const std::size_t n = this->block_size(head);
+				const word_type mask = this->block_mask(head);
+				if (mask == this_type::full_mask(n)) {
+					for (std::size_t k = 0; k < n; ++k) {
+						out[head + k] = tl::detail::invoke(f, in[head + k]);
+					}
+				}
+				else {
+					for (word_type m = mask; m != 0; m &= m - 1) {
+						const std::size_t k = this_type::lowest_bit(m);
+						out[head + k] = tl::detail::invoke(f, in[head + k]);
+					}
+				}
+				result.set_validity_word(head / word_bits, mask);
+			}
+			return result;
+		}
+
+		template <typename F>
+		auto and_then(F&& f) const -> optional_vector<typename std::decay_t<tl::detail::invoke_result_t<F&, const value_type&>>::value_type>
+		{
+			using result_type = typename std::decay_t<tl::detail::invoke_result_t<F&, const value_type&>>::value_type;
+			optional_vector<result_type> result(this->size());
+			result_type* const out = result.values().data();
+			const T* const in = values_.data();
+			for (std::size_t head = 0; head < this->size(); head += word_bits) {
+				word_type valid = 0;
+				for (word_type m = this->block_mask(head); m != 0; m &= m - 1) {
+					const std::size_t k = this_type::lowest_bit(m);
+					auto r = tl::detail::invoke(f, in[head + k]);
+					if (r.has_value()) {
+						out[head + k] = *std::move(r);
+						valid |= word_type(1) << k;
+					}
+				}
+				result.set_validity_word(head / word_bits, valid);
+			}
+			return result;
+		}
+
+		template <typename U>
+		std::vector<value_type> value_or(U&& dvalue) const
+		{
+			const value_type d = static_cast<value_type>(std::forward<U>(dvalue));
+			std::vector<value_type> result(this->size());
+			value_type* const out = result.data();
+			const T* const in = values_.data();
+			for (std::size_t head = 0; head < this->size(); head += word_bits) {
+				const std::size_t n = this->block_size(head);
+				const word_type mask = this->block_mask(head);
+				if (mask == this_type::full_mask(n)) {
+					for (std::size_t k = 0; k < n; ++k) {
+						out[head + k] = in[head + k];
+					}
+				}
+				else if (mask == 0) {
+					for (std::size_t k = 0; k < n; ++k) {
+						out[head + k] = d;
+					}
+				}
+				else {
+					for (std::size_t k = 0; k < n; ++k) {
+						out[head + k] = ((mask >> k) & 1u) ? in[head + k] : d;
+					}
+				}
+			}
+			return result;
+		}
+
+		template <typename U>
+		std::vector<value_type> operator /=(U&& dvalue) const
+		{
+			return this->value_or(std::forward<U>(dvalue));
+		}
+
+	private:
+		std::size_t block_size(std::size_t head) const noexcept
+		{
+			return this->size() - head < word_bits ? this->size() - head : word_bits;
+		}
+
+		word_type block_mask(std::size_t head) const noexcept
+		{
+			return opt_detail::validity_bits(*valid_, offset_ + head, this->block_size(head));
+		}
+
+		static word_type full_mask(std::size_t n) noexcept
+		{
+			return n == word_bits ? ~word_type(0) : ~(~word_type(0) << n);
+		}
+
+		// m must not be 0
+		static std::size_t lowest_bit(word_type m) noexcept
+		{
+			return static_cast<std::size_t>(bit_detail::countr_zero(m));
+		}
+
+	private:
+		span<T> values_;
+		bitmap_pointer valid_ = nullptr;
+		std::size_t offset_ = 0;
+
+	}; // class optional_span
+
+// -----------------------------------------------------------------------------
+//  optional_vector
+// -----------------------------------------------------------------------------
+	/*
+		Sequence of optional<T> in the columnar layout, i.e. a contiguous array of values
+		and a validity bitmap as Apache Arrow does, instead of std::vector<optional<T>>
+		which interleaves flags with values.
+		Values of invalid elements are value initialized.
+
+		Element access returns optional<T> for const vectors, and a proxy otherwise,
+		so that the code for std::vector<optional<T>> mostly compiles as is.
+		Bulk operations are those of optional_span.
+
+		ex)
+			qsb::optional_vector<double> rates = { qsb::optional<double>(0.01), qsb::nullopt, qsb::optional<double>(0.02) };
+			rates[1] = 0.015;
+			const auto bps = rates.transform([](double r) { return r * 1e4; });
+			const std::vector<double> filled = bps /= 0.0;
+	*/
+	template <typename T>
+	class optional_vector {
+	private:
+		using this_type = optional_vector;
+		static_assert(!std::is_same_v<T, bool>, "std::vector<bool> has no contiguous storage.");
+		template <typename U> friend class optional_span;
+
+	public:
+		using value_type = T;
+		using reference = opt_detail::optional_reference<T>;
+		using const_reference = optional<T>;
+
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		optional_vector() = default;
+
+		// size nullopts
+		explicit optional_vector(std::size_t size)
+			: values_(size), valid_(size)
+		{
+		}
+
+		optional_vector(std::initializer_list<optional<T>> values)
+		{
+			this->reserve(values.size());
+			for (const auto& value : values) {
+				this->push_back(value);
+			}
+		}
+
+		// throws std::invalid_argument if sizes are different
+		optional_vector(std::vector<T> values, util::bitmap valid)
+			: values_(std::move(values)), valid_(std::move(valid))
+		{
+			if (values_.size() != valid_.size()) {
+				throw std::invalid_argument("sizes of values and validity must be the same.");
+			}
+		}
+
+	// -------------------------------------------------------------------------
+	//  size
+	//
+		std::size_t size() const noexcept { return values_.size(); }
+		bool empty() const noexcept { return values_.empty(); }
+
+		void resize(std::size_t size)
+		{
+			this->grow(size, false, [this, size] { values_.resize(size); });
+		}
+
+		// reserves both values and validity, so that push_back does not reallocate either
+		void reserve(std::size_t size)
+		{
+			values_.reserve(size);
+			valid_.reserve(size);
+		}
+
+		void clear() noexcept
+		{
+			values_.clear();
+			valid_.clear();
+		}
+
+		void push_back(const T& value)
+		{
+			this->grow(this->size() + 1, true, [this, &value] { values_.push_back(value); });
+		}
+
+		void push_back(T&& value)
+		{
+			this->grow(this->size() + 1, true, [this, &value] { values_.push_back(std::move(value)); });
+		}
+
+		void push_back(nullopt_t)
+		{
+			this->grow(this->size() + 1, false, [this] { values_.emplace_back(); });
+		}
+
+		void push_back(const optional<T>& value)
+		{
+			if (value.has_value()) {
+				this->push_back(*value);
+			}
+			else {
+				this->push_back(nullopt);
+			}
+		}
+
+	// -------------------------------------------------------------------------
+	//  element access
+	//
+		bool has_value(std::size_t i) const noexcept { return valid_.test(i); }
+		std::size_t count() const noexcept { return valid_.count(); }
+
+		reference operator [](std::size_t i) noexcept
+		{
+			return reference(&values_[i], &valid_, i);
+		}
+
+		const_reference operator [](std::size_t i) const
+		{
+			return this->has_value(i) ? optional<T>(values_[i]) : optional<T>(nullopt);
+		}
+
+		span<T> values() noexcept { return span<T>(values_.data(), values_.size()); }
+		span<const T> values() const noexcept { return span<const T>(values_.data(), values_.size()); }
+		const util::bitmap& validity() const noexcept { return valid_; }
+
+		optional_span<T> view() noexcept { return optional_span<T>(this->values(), &valid_); }
+		optional_span<const T> view() const noexcept { return optional_span<const T>(this->values(), &valid_); }
+
+	// -------------------------------------------------------------------------
+	//  bulk operations
+	//
+		template <typename F>
+		auto transform(F&& f) const
+		{
+			return this->view().transform(std::forward<F>(f));
+		}
+
+		template <typename F>
+		auto and_then(F&& f) const
+		{
+			return this->view().and_then(std::forward<F>(f));
+		}
+
+		template <typename U>
+		std::vector<T> value_or(U&& dvalue) const
+		{
+			return this->view().value_or(std::forward<U>(dvalue));
+		}
+
+		template <typename U>
+		std::vector<T> operator /=(U&& dvalue) const
+		{
+			return this->view().value_or(std::forward<U>(dvalue));
+		}
+
+	private:
+		// resizes the validity first and restores it if resizing values throws,
+		// so that sizes of values and validity are always the same
+		template <typename F>
+		void grow(std::size_t size, bool valid, F&& resize_values)
+		{
+			valid_.resize(size, valid);
+			try {
+				resize_values();
+			}
+			catch (...) {
+				valid_.resize(values_.size());
+				throw;
+			}
+		}
+
+		void set_validity_word(std::size_t word_index, util::bitmap::word_type word) noexcept
+		{
+			valid_.set_word(word_index, word);
+		}
+
+	private:
+		std::vector<T> values_;
+		util::bitmap valid_;
+
+	}; // class optional_vector
+
+} // namespace qsb
@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include "../ranges.h"
+#include "to_str.h"
+#include "detail/report_writer.h"
+
+namespace qsb { namespace util {
+// -----------------------------------------------------------------------------
+//  report_options
+// -----------------------------------------------------------------------------
+	/*
+		rows_per_chunk	 : number of rows formatted into one buffer by a worker
+		threads			 : number of worker threads. 0 means std::thread::hardware_concurrency,
+						   and 1 formats and writes in the calling thread.
+		chunks_in_flight : maximum number of chunk buffers held at a time, which bounds the memory.
+						   0 means twice the number of threads.
+	*/
+	struct report_options {
+		std::size_t rows_per_chunk = 4096;
+		std::size_t threads = 0;
+		std::size_t chunks_in_flight = 0;
+	};
+
+// -----------------------------------------------------------------------------
+//  write_report
+// -----------------------------------------------------------------------------
+	/*
+		Writes rows to a stream, formatting chunks of rows on worker threads.
+		format_row(std::string& buffer, const Row& row) appends a row to the buffer,
+		typically by util::append_to or util::append_csv_row.
+		Chunks are written in order by one large write each,
+		so the output is byte for byte the same as a sequential run for any options.
+
+		An exception from format_row is rethrown after all threads are stopped,
+		and writing stops when the stream fails, which is reported by the stream state,
+		or by an exception if enabled by out.exceptions.
+
+		ex)
+			struct df_row { qsb::date date; double df; };
+			std::vector<df_row> rows = ...;
+			std::ofstream out("df.csv", std::ios::binary);
+			qsb::util::write_report(out, qsb::span<const df_row>(rows), [](std::string& buffer, const df_row& row) {
+				qsb::util::append_csv_row(buffer, row.date, qsb::util::to_string(row.df, 10, 0));
+			});
+	*/
+	template <typename Row, typename F>
+	void write_report(std::ostream& out, span<const Row> rows, F&& format_row, const report_options& options = report_options{})
+	{
+		const std::size_t rows_per_chunk = options.rows_per_chunk == 0 ? 1 : options.rows_per_chunk;
+		const std::size_t chunks = (rows.size() + rows_per_chunk - 1) / rows_per_chunk;
+		auto format_chunk = [&rows, &format_row, rows_per_chunk](std::string& buffer, std::size_t k) {
+			for (const auto& row : rows.subspan(k * rows_per_chunk, std::min(rows_per_chunk, rows.size() - k * rows_per_chunk))) {
+				format_row(buffer, row);
+			}
+		};
+
+		std::size_t threads = options.threads == 0 ? std::thread::hardware_concurrency() : options.threads;
+		threads = threads < chunks ? threads : chunks;
+		if (threads <= 1) {
+			report_detail::write_chunks_sequential(out, chunks, format_chunk);
+			return;
+		}
+		const std::size_t in_flight = options.chunks_in_flight == 0 ? 2 * threads : options.chunks_in_flight;
+		report_detail::write_chunks_parallel(out, chunks, threads, in_flight, format_chunk);
+	}
+
+// -----------------------------------------------------------------------------
+//  append_csv_row
+// -----------------------------------------------------------------------------
+	/*
+		Appends fields joined by ',' and terminated by '\n'. Each field is written by util::append_to.
+		Fields are not quoted, so they must not contain ',', '"' or line breaks.
+	*/
+	template <typename Buffer, typename T, typename ...Ts>
+	char* append_csv_row(Buffer& buffer, T&& field, Ts&& ...fields)
+	{
+		util::append_to(buffer, std::forward<T>(field));
+		((buffer.push_back(','), util::append_to(buffer, std::forward<Ts>(fields))), ...);
+		buffer.push_back('\n');
+		return buffer.data() + buffer.size();
+	}
+
+}} // namespace qsb::util
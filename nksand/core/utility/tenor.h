@@ -0,0 +1,175 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "from_str.h"
+
+namespace qsb {
+// -----------------------------------------------------------------------------
+//  tenor_unit
+// -----------------------------------------------------------------------------
+	/*
+		Units of tenor. Special tenors are units of their own with count 1.
+			overnight		: ON
+			tomorrow_next	: TN
+			spot_next		: SN
+			spot_week		: SW
+	*/
+	enum class tenor_unit : std::uint8_t {
+		day,
+		week,
+		month,
+		year,
+		overnight,
+		tomorrow_next,
+		spot_next,
+		spot_week,
+	};
+
+} // namespace qsb
+
+#include "detail/tenor.h"
+
+namespace qsb {
+// -----------------------------------------------------------------------------
+//  tenor
+// -----------------------------------------------------------------------------
+	/*
+		Length of a period used as a key of instruments, such as "ON", "1W", "3M" and "10Y".
+		Units are kept as written, so "12M" and "1Y" are different tenors.
+
+		Conversion from and to strings is provided by from_string_trait and to_string_trait,
+		and the parser is constexpr so that literals are resolved at compile time.
+
+		ex)
+			using namespace qsb::literals;
+			constexpr auto t = "3M"_tenor;
+			static_assert(t.count() == 3 && t.unit() == qsb::tenor_unit::month);
+			const auto u = qsb::util::from_string<qsb::tenor>("ON");
+			qsb::util::to_string(u);	// "ON"
+	*/
+	class tenor {
+	private:
+		using this_type = tenor;
+
+	public:
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		constexpr tenor() noexcept = default;
+
+		constexpr tenor(std::int32_t count, tenor_unit unit) noexcept
+			: count_(count), unit_(unit)
+		{
+		}
+
+	// -------------------------------------------------------------------------
+	//  get
+	//
+		constexpr std::int32_t count() const noexcept { return count_; }
+		constexpr tenor_unit unit() const noexcept { return unit_; }
+
+		constexpr bool is_special() const noexcept
+		{
+			return unit_ >= tenor_unit::overnight;
+		}
+
+	// -------------------------------------------------------------------------
+	//  conversion
+	//
+		// false for malformed strings, leaving out untouched
+		static constexpr bool try_from_string(std::string_view str, this_type& out) noexcept
+		{
+			std::int32_t count = 0;
+			tenor_unit unit = tenor_unit::day;
+			if (tenor_detail::parse_tenor(str, count, unit) != traits::from_string_errc::ok) {
+				return false;
+			}
+			out = this_type(count, unit);
+			return true;
+		}
+
+		// throws std::invalid_argument for malformed strings, which is a compile error in constant evaluation
+		static constexpr this_type from_string(std::string_view str)
+		{
+			this_type result;
+			if (!this_type::try_from_string(str, result)) {
+				throw std::invalid_argument("invalid tenor");
+			}
+			return result;
+		}
+
+		std::string to_string() const
+		{
+			switch (unit_) {
+			case tenor_unit::overnight:
+				return "ON";
+			case tenor_unit::tomorrow_next:
+				return "TN";
+			case tenor_unit::spot_next:
+				return "SN";
+			case tenor_unit::spot_week:
+				return "SW";
+			default:
+				return std::to_string(count_) + "DWMY"[static_cast<std::size_t>(unit_)];
+			}
+		}
+
+	// -------------------------------------------------------------------------
+	//  comparison
+	//
+		friend constexpr bool operator ==(const this_type& l, const this_type& r) noexcept
+		{
+			return l.count_ == r.count_ && l.unit_ == r.unit_;
+		}
+
+		friend constexpr bool operator !=(const this_type& l, const this_type& r) noexcept
+		{
+			return !(l == r);
+		}
+
+	private:
+		std::int32_t count_ = 0;
+		tenor_unit unit_ = tenor_unit::day;
+
+	}; // class tenor
+
+// -----------------------------------------------------------------------------
+//  literals
+// -----------------------------------------------------------------------------
+	namespace literals {
+		constexpr tenor operator ""_tenor(const char* str, std::size_t size)
+		{
+			return tenor::from_string(std::string_view(str, size));
+		}
+
+	} // namespace literals
+
+} // namespace qsb
+
+namespace qsb { namespace traits {
+// -----------------------------------------------------------------------------
+//  from_string_trait<tenor>
+// -----------------------------------------------------------------------------
+	template <>
+	struct from_string_trait<tenor> {
+		static constexpr from_string_errc try_apply(std::string_view str, tenor& out) noexcept
+		{
+			std::int32_t count = 0;
+			tenor_unit unit = tenor_unit::day;
+			const auto ec = tenor_detail::parse_tenor(str, count, unit);
+			if (ec == from_string_errc::ok) {
+				out = tenor(count, unit);
+			}
+			return ec;
+		}
+
+		static constexpr tenor apply(std::string_view str)
+		{
+			return tenor::from_string(str);
+		}
+	};
+
+}} // namespace qsb::traits
@@ -2,7 +2,11 @@
 
 #include <stdlib.h>
 #include <type_traits>
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <utility>
+#include "../ranges.h"
 
 namespace qsb { namespace traits {
 // -----------------------------------------------------------------------------
@@ -22,6 +26,17 @@ namespace qsb { namespace traits {
 		
 		So even when we do not provide a specialization of this trait, 
 		util::to_string works well if either of the above is defined. 
+
+		float, double and long double are specialized to write the shortest string
+		which is read back to the same value by util::from_string (not "%f" of std::to_string).
+		Use util::to_string(double, int, int) for a fixed number of decimals.
+
+		util::to_chars and util::append_to write into a caller provided buffer without allocation.
+		A specialization opts in to them by a static member function
+			static char* to_chars(char* first, char* last, const T& value);
+		which returns the end of the written characters, or nullptr if [first, last) is too short.
+		Otherwise, the string returned by apply is copied.
+		Numbers and std::string are specialized so.
 		ex)
 			namespace test {
 				struct to_str_test_class1 {};
@@ -41,7 +56,52 @@ namespace qsb { namespace traits {
 			}
 	*/
 	template <typename T, typename = void>
-	struct from_string_trait;
+	struct to_string_trait;
+
+// -----------------------------------------------------------------------------
+//  write_string_trait
+// -----------------------------------------------------------------------------
+	/*
+		traits::write_string_trait is a customization point for composite types,
+		which write their strings into a sink instead of returning std::string,
+		so that members are formatted without intermediate strings.
+		A sink is a growable char buffer, such as std::string and std::vector<char>.
+
+		A specialization provides
+			template <typename Sink>
+			static void write(Sink& sink, const T& value);			// required
+			static std::size_t estimate_size(const T& value);		// optional
+		where members are written by util::append_to(sink, member),
+		and estimate_size is used to reserve the sink once at the top-level call.
+
+		util::to_string and util::append_to use this trait
+		for types which to_string_trait does not support by itself.
+		Members without this trait are written by to_string_trait,
+		so ADL to_string/to_str and member functions keep working inside composites.
+
+		Specializations are provided for
+			qsb::optional<T>	: the value, or an empty string for nullopt
+			containers			: "[x0, x1, ...]"
+			std::pair/tuple		: "(x0, x1, ...)"
+		ex)
+			struct quote { double bid; double ask; };
+
+			template <>
+			struct qsb::traits::write_string_trait<quote> {
+				template <typename Sink>
+				static void write(Sink& sink, const quote& q)
+				{
+					qsb::util::append_to(sink, q.bid);
+					qsb::util::append_to(sink, "/");
+					qsb::util::append_to(sink, q.ask);
+				}
+			};
+
+			std::vector<quote> quotes = { { 99.5, 100.25 } };
+			qsb::util::to_string(quotes);	// "[99.5/100.25]"
+	*/
+	template <typename T, typename = void>
+	struct write_string_trait;
 
 }} // namespace qsb::traits
 
@@ -70,25 +130,136 @@ namespace qsb { namespace util {
 	}
 
 // -----------------------------------------------------------------------------
-//  to_string : (double, int, int) -> std::string
-// 	to_str	  : (double, int, int) -> std::string
+//  to_chars  : (char*, char*, T&&) -> char*
+// 	append_to : (Buffer&, T&&) -> char*
+// -----------------------------------------------------------------------------
+	/*
+		to_chars writes util::to_string(value) into [first, last)
+		and returns the end of the written characters, or nullptr if the range is too short.
+		Nothing is guaranteed about the content of the range when nullptr is returned.
+
+		append_to appends util::to_string(value) to a growable buffer,
+		such as std::string and std::vector<char>, and returns the end of the buffer.
+		The buffer can be reused over values to avoid allocations.
+
+		ex)
+			char buffer[32];
+			char* end = qsb::util::to_chars(buffer, buffer + sizeof(buffer), 42);	// "42"
+
+			std::string line;
+			qsb::util::append_to(line, 0.25);
+			line += ',';
+			qsb::util::append_to(line, 1.5, 2, 6);	// "0.25,  1.50"
+	*/
+	template <typename T, std::enable_if_t<
+		to_str_detail::trait_appliable<traits::to_string_trait<to_str_detail::remove_cvref_t<T>>, T&&>::value, std::nullptr_t
+	> = nullptr>
+	char* to_chars(char* first, char* last, T&& value)
+	{
+		using to_stringer = traits::to_string_trait<to_str_detail::remove_cvref_t<T>>;
+		return to_str_detail::to_chars_trait<to_stringer>(first, last, std::forward<T>(value));
+	}
+
+	template <typename Buffer, typename T, std::enable_if_t<
+		to_str_detail::trait_appliable<traits::to_string_trait<to_str_detail::remove_cvref_t<T>>, T&&>::value, std::nullptr_t
+	> = nullptr>
+	char* append_to(Buffer& buffer, T&& value)
+	{
+		using value_type = to_str_detail::remove_cvref_t<T>;
+		if constexpr (to_str_detail::writable<value_type>::value) {
+			to_str_detail::reserve_for(buffer, to_str_detail::estimate_value_size<value_type>(value));
+		}
+		to_str_detail::write_value<Buffer, value_type>(buffer, value);
+		return buffer.data() + buffer.size();
+	}
+
 // -----------------------------------------------------------------------------
-	std::string to_string(double d, int prec, int digits)
+//  to_chars  : (char*, char*, double, int, int) -> char*
+// 	append_to : (Buffer&, double, int, int) -> char*
+// -----------------------------------------------------------------------------
+	/*
+		Same as sprintf("%*.*f", digits, prec, d), where prec and digits are limited to 64.
+		Numbers whose absolute value is larger than 1e32 are written by "%f" without width
+		as std::to_string does.
+	*/
+	inline char* to_chars(char* first, char* last, double d, int prec, int digits) noexcept
 	{
 		if (d > 1.0e32 || d < -1.0e32)
 		{
-			return std::to_string(d);
+			return to_str_detail::to_chars_fixed(first, last, d, 6, 0);
+		}
+		return to_str_detail::to_chars_fixed(first, last, d, prec > 64 ? 64 : prec, digits > 64 ? 64 : digits);
+	}
+
+	template <typename Buffer>
+	char* append_to(Buffer& buffer, double d, int prec, int digits)
+	{
+		return to_str_detail::append_chars(buffer, [=](char* first, char* last) {
+			return util::to_chars(first, last, d, prec, digits);
+		});
+	}
+
+// -----------------------------------------------------------------------------
+//  format_fixed_batch : (Buffer&, span<const double>, int, int, string_view) -> char*
+// 	to_string_batch	   : (span<const double>, int, int, string_view) -> std::string
+// -----------------------------------------------------------------------------
+	/*
+		Columnar version of to_string(double, int, int).
+		Values are written into one contiguous buffer joined by the separator,
+		and each of them is byte for byte the same as util::to_string(d, prec, digits).
+		format_fixed_batch appends to a growable buffer and returns the end of it.
+
+		Digits of values whose scaled integer d * 10^prec fits in 64 bits are generated
+		16 at a time (by SSE2 when available) without sprintf.
+
+		ex)
+			const double dfs[] = { 1.0, 0.99875, 0.5 };
+			qsb::util::to_string_batch(dfs, 4, 0, ",");	// "1.0000,0.9988,0.5000"
+	*/
+	template <typename Buffer>
+	char* format_fixed_batch(Buffer& buffer, span<const double> values, int prec, int digits, std::string_view separator)
+	{
+		// enough for values in the fast path with the maximum width
+		const std::size_t room = to_str_detail::max_fixed_fast_size + 64 + separator.size();
+		std::size_t used = buffer.size();
+		for (std::size_t i = 0; i < values.size(); ++i) {
+			for (std::size_t required = used + room;; required *= 2) {
+				if (buffer.size() < required) {
+					buffer.resize(required < 2 * buffer.size() ? 2 * buffer.size() : required);
+				}
+				char* const first = buffer.data() + used;
+				char* const last = buffer.data() + buffer.size();
+				char* const head = i == 0 ? first : to_str_detail::copy_chars(first, last, separator);
+				char* const end = head ? util::to_chars(head, last, values[i], prec, digits) : nullptr;
+				if (end) {
+					used = static_cast<std::size_t>(end - buffer.data());
+					break;
+				}
+			}
 		}
-		char s[64]{};
-#ifdef _MSC_VER
-		sprintf_s(s, "%*.*f", digits > 64 ? 64 : digits, prec > 64 ? 64 : prec, d);
-#else
-		sprintf(s, "%*.*f", digits > 64 ? 64 : digits, prec > 64 ? 64 : prec, d);
-#endif
-		return std::string(s);
+		buffer.resize(used);
+		return buffer.data() + buffer.size();
+	}
+
+	inline std::string to_string_batch(span<const double> values, int prec, int digits, std::string_view separator)
+	{
+		std::string result;
+		util::format_fixed_batch(result, values, prec, digits, separator);
+		return result;
+	}
+
+// -----------------------------------------------------------------------------
+//  to_string : (double, int, int) -> std::string
+// 	to_str	  : (double, int, int) -> std::string
+// -----------------------------------------------------------------------------
+	inline std::string to_string(double d, int prec, int digits)
+	{
+		std::string result;
+		util::append_to(result, d, prec, digits);
+		return result;
 	}
 
-	std::string to_str(double d, int prec, int digits)
+	inline std::string to_str(double d, int prec, int digits)
 	{
 		return util::to_string(d, prec, digits);
 	}
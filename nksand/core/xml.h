@@ -1,2 +1,35 @@
 #pragma once
+#include "xml/internal.h"
 
+namespace qsb { namespace xml {
+// -----------------------------------------------------------------------------
+//  xml_doc, xml_node, xml_reader, xml_records
+// -----------------------------------------------------------------------------
+	/*
+		Facade over pugixml. pugixml is included only by core/xml/internal.cpp.
+
+		ex)
+			const auto doc = qsb::xml::xml_doc::load_file("quotes.xml");
+			for (auto quote = doc.root().child("Quote"); quote; quote = quote.next_sibling("Quote")) {
+				std::string_view id = quote.attr("id").str();	// view into the document, valid while doc is alive
+				const double rate = quote.attr("rate");		// converted by util::from_str without copy
+			}
+
+		xml_reader reads records one by one with memory independent of the size of the file.
+			qsb::xml::xml_reader reader("quotes.xml", "Quote");
+			while (const auto quote = reader.next()) {
+				const double rate = quote.attr("rate");
+			}
+
+		xml_records parses records of a large flat document on multiple threads.
+			const auto quotes = qsb::xml::xml_records::load_file("quotes.xml", "Quote");
+			for (const auto& quote : quotes.records()) {
+				const double rate = quote.attr("rate");
+			}
+	*/
+	using xml_doc = impl_layer::xml_doc_internal;
+	using xml_node = impl_layer::xml_node_internal;
+	using xml_reader = impl_layer::xml_reader_internal;
+	using xml_records = impl_layer::xml_records_internal;
+
+}} // namespace qsb::xml
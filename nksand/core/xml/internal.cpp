@@ -0,0 +1,926 @@
+#include "internal.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../../_external/zeux_pugixml/pugixml.hpp"
+#if defined(_WIN32)
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace qsb { namespace xml { namespace impl_layer {
+namespace {
+// -----------------------------------------------------------------------------
+//  mapped_file
+// -----------------------------------------------------------------------------
+	/*
+		Copy-on-write mapping of a whole file. The parser writes terminators and unescaped
+		characters into the pages, which are copied on the first write and never reach the file.
+	*/
+	class mapped_file {
+	private:
+		using this_type = mapped_file;
+
+	public:
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		mapped_file() = default;
+		mapped_file(const this_type&) = delete;
+		this_type& operator =(const this_type&) = delete;
+
+		~mapped_file()
+		{
+			this->unmap();
+		}
+
+		void map(const std::filesystem::path& path)
+		{
+#if defined(_WIN32)
+			const HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				throw_last_error(::GetLastError(), "failed to open ", path);
+			}
+			LARGE_INTEGER size;
+			if (!::GetFileSizeEx(file, &size)) {
+				const DWORD error = ::GetLastError();
+				::CloseHandle(file);
+				throw_last_error(error, "failed to get size of ", path);
+			}
+			size_ = static_cast<std::size_t>(size.QuadPart);
+			if (size_ == 0) {
+				::CloseHandle(file);
+				return;
+			}
+			const HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			const DWORD mapping_error = ::GetLastError();
+			::CloseHandle(file);
+			if (mapping == nullptr) {
+				throw_last_error(mapping_error, "failed to map ", path);
+			}
+			data_ = static_cast<char*>(::MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+			const DWORD view_error = ::GetLastError();
+			::CloseHandle(mapping);
+			if (data_ == nullptr) {
+				throw_last_error(view_error, "failed to map ", path);
+			}
+#else
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				throw_errno(errno, "failed to open ", path);
+			}
+			struct stat status;
+			if (::fstat(fd, &status) != 0) {
+				const int error = errno;
+				::close(fd);
+				throw_errno(error, "failed to get size of ", path);
+			}
+			size_ = static_cast<std::size_t>(status.st_size);
+			if (size_ == 0) {
+				::close(fd);
+				return;
+			}
+			void* data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			const int error = errno;
+			::close(fd);
+			if (data == MAP_FAILED) {
+				throw_errno(error, "failed to map ", path);
+			}
+			::madvise(data, size_, MADV_SEQUENTIAL);
+			data_ = static_cast<char*>(data);
+#endif
+		}
+
+	// -------------------------------------------------------------------------
+	//  get
+	//
+		char* data() const noexcept { return data_; }
+		std::size_t size() const noexcept { return size_; }
+
+	private:
+		void unmap() noexcept
+		{
+			if (data_ != nullptr) {
+#if defined(_WIN32)
+				::UnmapViewOfFile(data_);
+#else
+				::munmap(data_, size_);
+#endif
+			}
+			data_ = nullptr;
+			size_ = 0;
+		}
+
+#if defined(_WIN32)
+		// error is read right after the failed call, since cleanup calls may overwrite it
+		[[noreturn]] static void throw_last_error(DWORD error, const char* what, const std::filesystem::path& path)
+		{
+			throw std::system_error(static_cast<int>(error), std::system_category(), what + path.string());
+		}
+#else
+		// error is read right after the failed call, since cleanup calls may overwrite it
+		[[noreturn]] static void throw_errno(int error, const char* what, const std::filesystem::path& path)
+		{
+			throw std::system_error(error, std::generic_category(), what + path.string());
+		}
+#endif
+
+	private:
+		char* data_ = nullptr;
+		std::size_t size_ = 0;
+
+	}; // class mapped_file
+
+// -----------------------------------------------------------------------------
+//  helpers
+// -----------------------------------------------------------------------------
+	bool name_equals(const pugi::char_t* str, std::string_view name) noexcept
+	{
+		return std::strncmp(str, name.data(), name.size()) == 0 && str[name.size()] == '\0';
+	}
+
+	pugi::xml_node element_from(pugi::xml_node node) noexcept
+	{
+		while (node && node.type() != pugi::node_element) {
+			node = node.next_sibling();
+		}
+		return node;
+	}
+
+	pugi::xml_node element_from(pugi::xml_node node, std::string_view name) noexcept
+	{
+		for (node = impl_layer::element_from(node); node; node = impl_layer::element_from(node.next_sibling())) {
+			if (impl_layer::name_equals(node.name(), name)) {
+				break;
+			}
+		}
+		return node;
+	}
+
+	pugi::xml_attribute find_attr(pugi::xml_node node, std::string_view name) noexcept
+	{
+		for (auto attr = node.first_attribute(); attr; attr = attr.next_attribute()) {
+			if (impl_layer::name_equals(attr.name(), name)) {
+				return attr;
+			}
+		}
+		return pugi::xml_attribute();
+	}
+
+
+// -----------------------------------------------------------------------------
+//  scan_markup
+// -----------------------------------------------------------------------------
+	enum class markup_kind {
+		other,
+		start_tag,
+		empty_tag,
+		end_tag,
+	};
+
+	struct markup {
+		markup_kind kind = markup_kind::other;
+		std::size_t size = 0;
+		std::string_view name;		// name of a tag
+	};
+
+	// 1 if str starts with token, -1 if str is a proper prefix of token, 0 otherwise
+	int starts_with(std::string_view str, std::string_view token) noexcept
+	{
+		if (str.size() < token.size()) {
+			return token.compare(0, str.size(), str) == 0 ? -1 : 0;
+		}
+		return str.compare(0, token.size(), token) == 0 ? 1 : 0;
+	}
+
+	// finds '>' out of quotes (and out of brackets for declarations) from from
+	bool scan_to_close(std::string_view str, std::size_t from, bool brackets_allowed, markup& m) noexcept
+	{
+		char quote = '\0';
+		int brackets = 0;
+		for (std::size_t i = from; i < str.size(); ++i) {
+			const char c = str[i];
+			if (quote != '\0') {
+				quote = c == quote ? '\0' : quote;
+			}
+			else if (c == '"' || c == '\'') {
+				quote = c;
+			}
+			else if (brackets_allowed && (c == '[' || c == ']')) {
+				brackets += c == '[' ? 1 : -1;
+			}
+			else if (c == '>' && brackets == 0) {
+				m.size = i + 1;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/*
+		Scans the markup at the beginning of str, which starts with '<'.
+		Returns false if str ends before the end of the markup.
+	*/
+	bool scan_markup(std::string_view str, markup& m) noexcept
+	{
+		const auto terminate = [&m, str](std::string_view terminator, std::size_t from) {
+			const auto i = str.find(terminator, from);
+			m.size = i + terminator.size();
+			return i != std::string_view::npos;
+		};
+		if (str.size() < 2) {
+			return false;
+		}
+
+		switch (str[1]) {
+		case '?':
+			return terminate("?>", 2);
+
+		case '!':
+			for (const auto& [token, terminator] : { std::pair<std::string_view, std::string_view>("<!--", "-->"), { "<![CDATA[", "]]>" } }) {
+				const int starts = impl_layer::starts_with(str, token);
+				if (starts != 0) {
+					return starts > 0 && terminate(terminator, token.size());
+				}
+			}
+			// <!DOCTYPE ...> with an internal subset in brackets
+			return impl_layer::scan_to_close(str, 2, true, m);
+
+		case '/':
+			m.kind = markup_kind::end_tag;
+			return terminate(">", 2);
+
+		default: {
+			std::size_t i = 1;
+			while (i < str.size() && !std::strchr(" \t\r\n/>", str[i])) {
+				++i;
+			}
+			m.name = str.substr(1, i - 1);
+			if (!impl_layer::scan_to_close(str, i, false, m)) {
+				return false;
+			}
+			m.kind = str[m.size - 2] == '/' ? markup_kind::empty_tag : markup_kind::start_tag;
+			return true;
+		}
+		}
+	}
+
+
+// -----------------------------------------------------------------------------
+//  run_parallel
+// -----------------------------------------------------------------------------
+	// calls f(k) for k in [0, count) on threads, and rethrows the exception of the smallest k
+	template <typename F>
+	void run_parallel(std::size_t count, std::size_t threads, F&& f)
+	{
+		threads = std::min(threads, count);
+		if (threads <= 1) {
+			for (std::size_t k = 0; k < count; ++k) {
+				f(k);
+			}
+			return;
+		}
+
+		std::vector<std::exception_ptr> errors(count);
+		std::atomic<std::size_t> next { 0 };
+		const auto work = [&] {
+			for (std::size_t k = next++; k < count; k = next++) {
+				try {
+					f(k);
+				}
+				catch (...) {
+					errors[k] = std::current_exception();
+				}
+			}
+		};
+		std::vector<std::thread> workers;
+		std::exception_ptr spawn_error;
+		try {
+			workers.reserve(threads);
+			for (std::size_t t = 0; t < threads; ++t) {
+				workers.emplace_back(work);
+			}
+		}
+		catch (...) {
+			// started workers skip the remaining work and must be joined before std::thread is destroyed
+			spawn_error = std::current_exception();
+			next = count;
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		if (spawn_error) {
+			std::rethrow_exception(spawn_error);
+		}
+		for (const auto& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+
+// -----------------------------------------------------------------------------
+//  scan_records
+// -----------------------------------------------------------------------------
+	struct record_range {
+		std::size_t begin;
+		std::size_t end;
+	};
+
+	[[noreturn]] void throw_malformed(std::size_t offset, const char* what)
+	{
+		throw std::runtime_error("malformed xml at offset " + std::to_string(offset) + ": " + what);
+	}
+
+	struct markup_scan {
+		std::size_t resume;										// end of the last markup
+		std::size_t unterminated = std::string_view::npos;		// beginning of a markup without its end
+	};
+
+	// calls f(m, at) for markups starting in [from, to) while f returns true
+	template <typename F>
+	markup_scan for_each_markup(std::string_view xml, std::size_t from, std::size_t to, F&& f)
+	{
+		markup_scan result { from };
+		for (auto at = xml.find('<', from); at < to; at = xml.find('<', result.resume)) {
+			markup m;
+			if (!impl_layer::scan_markup(xml.substr(at), m)) {
+				result.unterminated = at;
+				break;
+			}
+			result.resume = at + m.size;
+			if (!f(m, at)) {
+				break;
+			}
+		}
+		return result;
+	}
+
+	// records found in a segment of the document
+	struct segment_records {
+		std::vector<record_range> records;
+		std::size_t close = std::string_view::npos;		// end of a record opened in a previous segment
+		std::size_t open = std::string_view::npos;		// beginning of a record closed in a following segment
+		std::size_t roots[2] = { std::string_view::npos, std::string_view::npos };
+		std::size_t root_count = 0;
+		std::size_t error = std::string_view::npos;
+		const char* what = nullptr;
+	};
+
+	/*
+		Ranges of records in xml, the children of the document element with record_name,
+		or all children if record_name is empty. Only markups are scanned, without parsing.
+
+		The document is split into segments scanned by threads in two passes.
+		'<' appears only at the beginning of markups except in comments, CDATA, PIs and DOCTYPE,
+		so a segment is scanned from its first '<' speculatively. The first pass finds the depth
+		at the end of each segment, and the segment is scanned again sequentially
+		if the last markup of the previous segment ends after its first '<'.
+		The second pass finds records with the depth at the beginning of each segment,
+		and records across segments are joined in order.
+		Results and errors are the same as those of one segment for any number of threads.
+	*/
+	std::vector<record_range> scan_records(std::string_view xml, std::string_view record_name, std::size_t threads)
+	{
+		constexpr auto npos = std::string_view::npos;
+		const std::size_t segments = std::max<std::size_t>(std::min(threads, xml.size() / 4096), 1);
+		const auto segment_end = [&xml, segments](std::size_t w) { return xml.size() / segments * (w + 1) + (w + 1 == segments ? xml.size() % segments : 0); };
+
+		// first pass: resumes[w] is the end of the last markup starting in segment w
+		std::vector<std::size_t> froms(segments, 0), resumes(segments);
+		std::vector<std::ptrdiff_t> deltas(segments, 0);
+		const auto measure = [&](std::size_t w) {
+			deltas[w] = 0;
+			const auto scan = impl_layer::for_each_markup(xml, froms[w], segment_end(w), [&deltas, w](const markup& m, std::size_t) {
+				deltas[w] += m.kind == markup_kind::start_tag ? 1 : m.kind == markup_kind::end_tag ? -1 : 0;
+				return true;
+			});
+			resumes[w] = scan.unterminated == npos ? scan.resume : xml.size();
+		};
+		for (std::size_t w = 1; w < segments; ++w) {
+			froms[w] = segment_end(w - 1);
+		}
+		impl_layer::run_parallel(segments, threads, measure);
+		for (std::size_t w = 1; w < segments; ++w) {
+			if (resumes[w - 1] > xml.find('<', froms[w])) {
+				froms[w] = resumes[w - 1];
+				measure(w);
+			}
+		}
+
+		// second pass
+		std::ptrdiff_t depth = 0;
+		std::vector<std::ptrdiff_t> start_depths(segments);
+		for (std::size_t w = 0; w < segments; ++w) {
+			start_depths[w] = depth;
+			depth += deltas[w];
+		}
+		const auto is_record = [record_name](std::string_view name) { return record_name.empty() || name == record_name; };
+		std::vector<segment_records> found(segments);
+		impl_layer::run_parallel(segments, threads, [&](std::size_t w) {
+			auto& seg = found[w];
+			std::ptrdiff_t d = start_depths[w];
+			bool open_at_start = d >= 2;
+			std::size_t record_begin = npos;
+			const auto scan = impl_layer::for_each_markup(xml, froms[w], segment_end(w), [&](const markup& m, std::size_t at) {
+				if (m.kind == markup_kind::start_tag || m.kind == markup_kind::empty_tag) {
+					if (d == 0 && seg.root_count < 2) {
+						seg.roots[seg.root_count++] = at;
+					}
+					if (d == 1 && is_record(m.name)) {
+						if (m.kind == markup_kind::empty_tag) {
+							seg.records.push_back({ at, at + m.size });
+						}
+						else {
+							record_begin = at;
+						}
+					}
+					d += m.kind == markup_kind::start_tag ? 1 : 0;
+				}
+				else if (m.kind == markup_kind::end_tag) {
+					if (d == 0) {
+						seg.error = at;
+						seg.what = "unexpected end tag";
+						return false;
+					}
+					if (--d == 1) {
+						if (record_begin != npos) {
+							seg.records.push_back({ record_begin, at + m.size });
+							record_begin = npos;
+						}
+						else if (open_at_start) {
+							seg.close = at + m.size;
+						}
+						open_at_start = false;
+					}
+				}
+				return true;
+			});
+			if (scan.unterminated != npos) {
+				seg.error = scan.unterminated;
+				seg.what = "unterminated markup";
+			}
+			seg.open = record_begin;
+		});
+
+		std::vector<record_range> records;
+		std::size_t pending = npos;
+		std::size_t roots = 0;
+		for (auto& seg : found) {
+			std::size_t error = seg.error;
+			const char* what = seg.what;
+			if (roots + seg.root_count >= 2 && seg.roots[roots == 0 ? 1 : 0] < error) {
+				error = seg.roots[roots == 0 ? 1 : 0];
+				what = "multiple document elements";
+			}
+			if (what != nullptr) {
+				impl_layer::throw_malformed(error, what);
+			}
+			roots += seg.root_count;
+			if (seg.close != npos && pending != npos) {
+				records.push_back({ pending, seg.close });
+				pending = npos;
+			}
+			records.insert(records.end(), seg.records.begin(), seg.records.end());
+			pending = seg.open != npos ? seg.open : pending;
+		}
+		if (depth != 0) {
+			impl_layer::throw_malformed(xml.size(), "unexpected end of document");
+		}
+		if (roots == 0) {
+			impl_layer::throw_malformed(xml.size(), "no document element");
+		}
+		return records;
+	}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+//  xml_doc_impl
+// -----------------------------------------------------------------------------
+	class xml_doc_impl {
+	public:
+		// parses size characters at buffer in place. buffer must outlive the document.
+		void parse(char* buffer, std::size_t size, const std::string& source)
+		{
+			// an empty buffer is parsed in place of a terminator, which results in no document element
+			char empty = '\0';
+			const auto result = size == 0
+				? document.load_buffer_inplace(&empty, 0)
+				: document.load_buffer_inplace(buffer, size);
+			if (!result) {
+				throw std::runtime_error("failed to parse " + source + " at offset "
+					+ std::to_string(result.offset) + ": " + result.description());
+			}
+		}
+
+	public:
+		mapped_file mapping;
+		std::unique_ptr<char[]> buffer;
+		pugi::xml_document document;
+
+	}; // class xml_doc_impl
+
+// -----------------------------------------------------------------------------
+//  xml_reader_impl
+// -----------------------------------------------------------------------------
+	/*
+		buffer_[0, end_) holds the stream from offset_, and markups are scanned from pos_
+		to track the depth of elements. A record, the range from the start tag of a child of
+		the document element to its end tag, is parsed in place of the buffer.
+		Scanned characters before the current record are dropped when the buffer is refilled,
+		and the buffer grows only when a record does not fit in it.
+	*/
+	class xml_reader_impl {
+	private:
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+	public:
+		xml_reader_impl(std::istream& in, std::string_view record_name, std::size_t buffer_size)
+			: in_(&in), record_name_(record_name), buffer_(std::max<std::size_t>(buffer_size, 64))
+		{
+		}
+
+		xml_reader_impl(std::unique_ptr<std::istream> in, std::string_view record_name, std::size_t buffer_size)
+			: xml_reader_impl(*in, record_name, buffer_size)
+		{
+			owned_ = std::move(in);
+		}
+
+		xml_node_internal next()
+		{
+			std::size_t record_begin = npos;
+			for (;;) {
+				const auto lt = static_cast<const char*>(std::memchr(buffer_.data() + pos_, '<', end_ - pos_));
+				if (lt == nullptr) {
+					pos_ = end_;
+					if (!this->fill(record_begin == npos ? end_ : record_begin, record_begin)) {
+						if (record_begin != npos || depth_ != 0) {
+							this->throw_malformed(end_, "unexpected end of document");
+						}
+						if (!root_seen_) {
+							this->throw_malformed(end_, "no document element");
+						}
+						return xml_node_internal();
+					}
+					continue;
+				}
+
+				const auto at = static_cast<std::size_t>(lt - buffer_.data());
+				markup m;
+				if (!impl_layer::scan_markup(std::string_view(buffer_.data() + at, end_ - at), m)) {
+					pos_ = at;
+					if (!this->fill(record_begin == npos ? at : record_begin, record_begin)) {
+						this->throw_malformed(pos_, "unterminated markup");
+					}
+					continue;
+				}
+				pos_ = at + m.size;
+
+				switch (m.kind) {
+				case markup_kind::start_tag:
+					this->check_root(at);
+					if (depth_ == 1 && record_begin == npos && this->is_record(m.name)) {
+						record_begin = at;
+					}
+					++depth_;
+					break;
+
+				case markup_kind::empty_tag:
+					this->check_root(at);
+					if (depth_ == 1 && record_begin == npos && this->is_record(m.name)) {
+						return this->parse(at, pos_);
+					}
+					break;
+
+				case markup_kind::end_tag:
+					if (depth_ == 0) {
+						this->throw_malformed(at, "unexpected end tag");
+					}
+					--depth_;
+					if (depth_ == 1 && record_begin != npos) {
+						return this->parse(record_begin, pos_);
+					}
+					break;
+
+				default:
+					break;
+				}
+			}
+		}
+
+	private:
+		// drops characters before keep and reads the stream. returns false at the end of the stream.
+		bool fill(std::size_t keep, std::size_t& record_begin)
+		{
+			if (keep > 0) {
+				std::memmove(buffer_.data(), buffer_.data() + keep, end_ - keep);
+				end_ -= keep;
+				pos_ -= keep;
+				offset_ += keep;
+				record_begin = record_begin == npos ? npos : record_begin - keep;
+			}
+			if (end_ == buffer_.size()) {
+				buffer_.resize(2 * buffer_.size());
+			}
+			if (eof_) {
+				return false;
+			}
+			in_->read(buffer_.data() + end_, static_cast<std::streamsize>(buffer_.size() - end_));
+			if (in_->bad()) {
+				throw std::runtime_error("failed to read xml at offset " + std::to_string(offset_ + end_));
+			}
+			const auto size = static_cast<std::size_t>(in_->gcount());
+			end_ += size;
+			eof_ = size == 0;
+			return !eof_;
+		}
+
+		void check_root(std::size_t at)
+		{
+			if (depth_ == 0 && root_seen_) {
+				this->throw_malformed(at, "multiple document elements");
+			}
+			root_seen_ = true;
+		}
+
+		bool is_record(std::string_view name) const noexcept
+		{
+			return record_name_.empty() || name == record_name_;
+		}
+
+		xml_node_internal parse(std::size_t begin, std::size_t end)
+		{
+			const auto result = document_.load_buffer_inplace(buffer_.data() + begin, end - begin, pugi::parse_default, pugi::encoding_utf8);
+			if (!result) {
+				throw std::runtime_error("failed to parse record at offset "
+					+ std::to_string(offset_ + begin + static_cast<std::size_t>(result.offset)) + ": " + result.description());
+			}
+			return xml_node_internal(document_.document_element().internal_object());
+		}
+
+		[[noreturn]] void throw_malformed(std::size_t at, const char* what) const
+		{
+			impl_layer::throw_malformed(offset_ + at, what);
+		}
+
+	private:
+		std::unique_ptr<std::istream> owned_;
+		std::istream* in_;
+		std::string record_name_;
+		std::vector<char> buffer_;
+		std::size_t end_ = 0;
+		std::size_t pos_ = 0;
+		std::size_t offset_ = 0;
+		std::size_t depth_ = 0;
+		bool root_seen_ = false;
+		bool eof_ = false;
+		pugi::xml_document document_;
+
+	}; // class xml_reader_impl
+
+// -----------------------------------------------------------------------------
+//  xml_records_impl
+// -----------------------------------------------------------------------------
+	/*
+		Records are found by scan_records, and split into chunks of contiguous records
+		of about the same number of characters. Each chunk is parsed in place as a fragment
+		into its own document by a worker, and its records are stored at their indices,
+		so that the order and the results do not depend on the number of threads.
+		The error of the first chunk in order is rethrown, as in a sequential run.
+	*/
+	class xml_records_impl {
+	public:
+		void load(char* data, std::size_t size, std::string_view record_name, std::size_t threads)
+		{
+			threads = threads == 0 ? std::max<std::size_t>(std::thread::hardware_concurrency(), 1) : threads;
+			const auto ranges = impl_layer::scan_records(std::string_view(data, size), record_name, threads);
+			records.resize(ranges.size());
+			if (ranges.empty()) {
+				return;
+			}
+
+			// chunk k has records [firsts[k], firsts[k + 1])
+			const std::size_t total = ranges.back().end - ranges.front().begin;
+			const std::size_t target = std::max<std::size_t>(total / (4 * threads), 1);
+			std::vector<std::size_t> firsts { 0 };
+			for (std::size_t i = 1; i < ranges.size(); ++i) {
+				if (ranges[i].end - ranges[firsts.back()].begin > target) {
+					firsts.push_back(i);
+				}
+			}
+			firsts.push_back(ranges.size());
+			const std::size_t chunks = firsts.size() - 1;
+			documents = std::make_unique<pugi::xml_document[]>(chunks);
+
+			impl_layer::run_parallel(chunks, threads, [&](std::size_t k) {
+				const auto first = ranges[firsts[k]].begin;
+				const auto last = ranges[firsts[k + 1] - 1].end;
+				const auto result = documents[k].load_buffer_inplace(data + first, last - first,
+					pugi::parse_default | pugi::parse_fragment, pugi::encoding_utf8);
+				if (!result) {
+					throw std::runtime_error("failed to parse record at offset "
+						+ std::to_string(first + static_cast<std::size_t>(result.offset)) + ": " + result.description());
+				}
+
+				std::size_t i = firsts[k];
+				for (auto node = impl_layer::element_from(documents[k].first_child()); node; node = impl_layer::element_from(node.next_sibling())) {
+					if (record_name.empty() || impl_layer::name_equals(node.name(), record_name)) {
+						records[i++] = xml_node_internal(node.internal_object());
+					}
+				}
+			});
+		}
+
+	public:
+		mapped_file mapping;
+		std::unique_ptr<char[]> buffer;
+		std::unique_ptr<pugi::xml_document[]> documents;
+		std::vector<xml_node_internal> records;
+
+	}; // class xml_records_impl
+
+// -----------------------------------------------------------------------------
+//  xml_doc_internal
+// -----------------------------------------------------------------------------
+	xml_doc_internal::xml_doc_internal() noexcept = default;
+	xml_doc_internal::xml_doc_internal(this_type&&) noexcept = default;
+	xml_doc_internal::~xml_doc_internal() = default;
+
+	xml_doc_internal::xml_doc_internal(std::unique_ptr<xml_doc_impl> pimpl) noexcept
+		: pimpl_(std::move(pimpl))
+	{
+	}
+
+	xml_doc_internal xml_doc_internal::load_file(const std::filesystem::path& path)
+	{
+		auto pimpl = std::make_unique<xml_doc_impl>();
+		pimpl->mapping.map(path);
+		pimpl->parse(pimpl->mapping.data(), pimpl->mapping.size(), path.string());
+		return this_type(std::move(pimpl));
+	}
+
+	xml_doc_internal xml_doc_internal::load_string(std::string_view xml)
+	{
+		auto pimpl = std::make_unique<xml_doc_impl>();
+		pimpl->buffer = std::make_unique<char[]>(xml.size() + 1);
+		std::memcpy(pimpl->buffer.get(), xml.data(), xml.size());
+		pimpl->parse(pimpl->buffer.get(), xml.size(), "string");
+		return this_type(std::move(pimpl));
+	}
+
+	xml_doc_internal& xml_doc_internal::operator =(this_type&&) noexcept = default;
+
+	xml_node_internal xml_doc_internal::root() const
+	{
+		if (!pimpl_) {
+			return xml_node_internal();
+		}
+		return xml_node_internal(pimpl_->document.document_element().internal_object());
+	}
+
+// -----------------------------------------------------------------------------
+//  xml_node_internal
+// -----------------------------------------------------------------------------
+	std::string_view xml_node_internal::name() const noexcept
+	{
+		return pugi::xml_node(node_).name();
+	}
+
+	util::convertible_string<std::string_view> xml_node_internal::text() const noexcept
+	{
+		return util::convertible_string<std::string_view>(std::string_view(pugi::xml_node(node_).child_value()));
+	}
+
+	util::convertible_string<std::string_view> xml_node_internal::attr(std::string_view name) const noexcept
+	{
+		return util::convertible_string<std::string_view>(std::string_view(impl_layer::find_attr(pugi::xml_node(node_), name).value()));
+	}
+
+	bool xml_node_internal::has_attr(std::string_view name) const noexcept
+	{
+		return !impl_layer::find_attr(pugi::xml_node(node_), name).empty();
+	}
+
+	xml_node_internal xml_node_internal::parent() const noexcept
+	{
+		const auto parent = pugi::xml_node(node_).parent();
+		return this_type(parent.type() == pugi::node_element ? parent.internal_object() : nullptr);
+	}
+
+	xml_node_internal xml_node_internal::first_child() const noexcept
+	{
+		return this_type(impl_layer::element_from(pugi::xml_node(node_).first_child()).internal_object());
+	}
+
+	xml_node_internal xml_node_internal::child(std::string_view name) const noexcept
+	{
+		return this_type(impl_layer::element_from(pugi::xml_node(node_).first_child(), name).internal_object());
+	}
+
+	xml_node_internal xml_node_internal::next_sibling() const noexcept
+	{
+		return this_type(impl_layer::element_from(pugi::xml_node(node_).next_sibling()).internal_object());
+	}
+
+	xml_node_internal xml_node_internal::next_sibling(std::string_view name) const noexcept
+	{
+		return this_type(impl_layer::element_from(pugi::xml_node(node_).next_sibling(), name).internal_object());
+	}
+
+// -----------------------------------------------------------------------------
+//  xml_reader_internal
+// -----------------------------------------------------------------------------
+	xml_reader_internal::xml_reader_internal(const std::filesystem::path& path, std::string_view record_name, std::size_t buffer_size)
+	{
+		auto in = std::make_unique<std::ifstream>(path, std::ios::binary);
+		if (!in->is_open()) {
+			// std::filebuf does not tell the reason, which is asked to the file system instead of errno
+			std::error_code error;
+			const auto status = std::filesystem::status(path, error);
+			if (!error) {
+				const auto reason = !std::filesystem::exists(status) ? std::errc::no_such_file_or_directory
+					: std::filesystem::is_directory(status) ? std::errc::is_a_directory
+					: std::errc::permission_denied;
+				error = std::make_error_code(reason);
+			}
+			throw std::system_error(error, "failed to open " + path.string());
+		}
+		pimpl_ = std::make_unique<xml_reader_impl>(std::move(in), record_name, buffer_size);
+	}
+
+	xml_reader_internal::xml_reader_internal(std::istream& in, std::string_view record_name, std::size_t buffer_size)
+		: pimpl_(std::make_unique<xml_reader_impl>(in, record_name, buffer_size))
+	{
+	}
+
+	xml_reader_internal::xml_reader_internal(this_type&&) noexcept = default;
+	xml_reader_internal::~xml_reader_internal() = default;
+	xml_reader_internal& xml_reader_internal::operator =(this_type&&) noexcept = default;
+
+	xml_node_internal xml_reader_internal::next()
+	{
+		return pimpl_->next();
+	}
+
+// -----------------------------------------------------------------------------
+//  xml_records_internal
+// -----------------------------------------------------------------------------
+	xml_records_internal::xml_records_internal() noexcept = default;
+	xml_records_internal::xml_records_internal(this_type&&) noexcept = default;
+	xml_records_internal::~xml_records_internal() = default;
+
+	xml_records_internal::xml_records_internal(std::unique_ptr<xml_records_impl> pimpl) noexcept
+		: pimpl_(std::move(pimpl))
+	{
+	}
+
+	xml_records_internal xml_records_internal::load_file(const std::filesystem::path& path, std::string_view record_name, std::size_t threads)
+	{
+		auto pimpl = std::make_unique<xml_records_impl>();
+		pimpl->mapping.map(path);
+		pimpl->load(pimpl->mapping.data(), pimpl->mapping.size(), record_name, threads);
+		return this_type(std::move(pimpl));
+	}
+
+	xml_records_internal xml_records_internal::load_string(std::string_view xml, std::string_view record_name, std::size_t threads)
+	{
+		auto pimpl = std::make_unique<xml_records_impl>();
+		pimpl->buffer = std::make_unique<char[]>(xml.size() + 1);
+		std::memcpy(pimpl->buffer.get(), xml.data(), xml.size());
+		pimpl->load(pimpl->buffer.get(), xml.size(), record_name, threads);
+		return this_type(std::move(pimpl));
+	}
+
+	xml_records_internal& xml_records_internal::operator =(this_type&&) noexcept = default;
+
+	span<const xml_node_internal> xml_records_internal::records() const noexcept
+	{
+		if (!pimpl_) {
+			return span<const xml_node_internal>();
+		}
+		return span<const xml_node_internal>(pimpl_->records);
+	}
+
+}}} // namespace qsb::xml::impl_layer
@@ -1,5 +1,17 @@
 #pragma once
+#include <cstddef>
+#include <filesystem>
+#include <iosfwd>
 #include <memory>
+#include <string_view>
+#include <type_traits>
+#include "../ranges.h"
+#include "../utility/from_str.h"
+
+namespace pugi {
+	struct xml_node_struct;
+
+} // namespace pugi
 
 namespace qsb { namespace xml { namespace impl_layer {
 // -----------------------------------------------------------------------------
@@ -7,50 +19,232 @@ namespace qsb { namespace xml { namespace impl_layer {
 // -----------------------------------------------------------------------------
 	class xml_doc_impl;
 	class xml_doc_internal;
-	class xml_node_impl;
 	class xml_node_internal;
+	class xml_reader_impl;
+	class xml_reader_internal;
+	class xml_records_impl;
+	class xml_records_internal;
 
 // -----------------------------------------------------------------------------
 //  xml_doc_internal
 // -----------------------------------------------------------------------------
+	/*
+		Document parsed in place of a buffer owned by the document.
+			load_file	: maps the file copy-on-write and parses the mapped pages,
+						  so the file is neither read into a heap buffer nor copied.
+			load_string	: copies the string into a buffer and parses it.
+
+		Names and texts of nodes are views into the buffer, and nodes refer to the document.
+		Both are valid until the document is destroyed. Moving the document keeps them valid.
+		Errors of the file system are thrown as std::system_error,
+		and parse errors as std::runtime_error with the offset of the error.
+	*/
 	class xml_doc_internal {
+	private:
+		using this_type = xml_doc_internal;
+
+	public:
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		xml_doc_internal() noexcept;
+		xml_doc_internal(const this_type&) = delete;
+		xml_doc_internal(this_type&&) noexcept;
+		~xml_doc_internal();
+
+		static this_type load_file(const std::filesystem::path& path);
+		static this_type load_string(std::string_view xml);
+
+	// -------------------------------------------------------------------------
+	//  assignments
+	//
+		this_type& operator =(const this_type&) = delete;
+		this_type& operator =(this_type&&) noexcept;
+
+	// -------------------------------------------------------------------------
+	//  get node
+	//
+		// document element, or an empty node for an empty document
+		xml_node_internal root() const;
+
+	private:
+		explicit xml_doc_internal(std::unique_ptr<xml_doc_impl> pimpl) noexcept;
+
+	private:
+		std::unique_ptr<xml_doc_impl> pimpl_;
 
 	}; // class xml_doc_internal
 
 // -----------------------------------------------------------------------------
 //  xml_node_internal
 // -----------------------------------------------------------------------------
+	/*
+		Element of xml_doc_internal. A default constructed node is empty,
+		and navigation from an empty node results in an empty node.
+		Returned strings are empty for an empty node or a missing attribute.
+
+		attr and text return convertible_string viewing the characters in the document,
+		which are converted by traits::from_string_trait without std::string temporaries.
+			const double rate = node.attr("rate").as<double>();
+			const qsb::optional<int> days = node.attr("days").maybe<int>();	// nullopt if missing
+			const qsb::date date = node.child("Date").text();
+
+		A node is a handle of the pugixml node, which is trivially copyable and as large as a pointer,
+		so that navigation and copies do not allocate.
+	*/
 	class xml_node_internal {
 	private:
 		using this_type = xml_node_internal;
+		friend class xml_doc_internal;
+		friend class xml_reader_impl;
+		friend class xml_records_impl;
 
 	public:
 	// -------------------------------------------------------------------------
 	//  constructors
 	//
-		xml_node_internal() = default;
-		xml_node_internal(const this_type&);
-		xml_node_internal(this_type&&) noexcept = default;		
+		constexpr xml_node_internal() noexcept = default;
+
+	// -------------------------------------------------------------------------
+	//  get value
+	//
+		bool empty() const noexcept { return node_ == nullptr; }
+		explicit operator bool() const noexcept { return !this->empty(); }
+
+		std::string_view name() const noexcept;
+		util::convertible_string<std::string_view> text() const noexcept;
+		util::convertible_string<std::string_view> attr(std::string_view name) const noexcept;
+		bool has_attr(std::string_view name) const noexcept;
+
+	// -------------------------------------------------------------------------
+	//  get node
+	//
+		xml_node_internal parent() const noexcept;
+		xml_node_internal first_child() const noexcept;
+		xml_node_internal child(std::string_view name) const noexcept;
+		xml_node_internal next_sibling() const noexcept;
+		xml_node_internal next_sibling(std::string_view name) const noexcept;
+
+	// -------------------------------------------------------------------------
+	//  compare
+	//
+		friend bool operator ==(const this_type& lhs, const this_type& rhs) noexcept { return lhs.node_ == rhs.node_; }
+		friend bool operator !=(const this_type& lhs, const this_type& rhs) noexcept { return lhs.node_ != rhs.node_; }
+
+	private:
+		explicit constexpr xml_node_internal(pugi::xml_node_struct* node) noexcept : node_(node) {}
+
+	private:
+		pugi::xml_node_struct* node_ = nullptr;
+
+	}; // class xml_node_internal
+
+	static_assert(std::is_trivially_copyable_v<xml_node_internal>, "node must be a trivially copyable handle.");
+
+// -----------------------------------------------------------------------------
+//  xml_reader_internal
+// -----------------------------------------------------------------------------
+	/*
+		Pull reader of records, the children of the document element, which reads a stream
+		through a sliding buffer and parses one record at a time in place of the buffer.
+		Memory use is bounded by the buffer and the largest record, independent of the size of the stream.
+			xml_reader_internal reader("quotes.xml", "Quote");
+			while (const auto quote = reader.next()) {
+				const double rate = quote.attr("rate");
+			}
+
+		Children with record_name are records, or all children if record_name is empty.
+		A record is parsed as a standalone document, so the stream must be UTF-8
+		and entities declared in DOCTYPE are not expanded.
+		The node returned by next and views into it are valid until the next call of next.
+		Malformed markup and parse errors of records are thrown as std::runtime_error
+		with the offset in the stream.
+	*/
+	class xml_reader_internal {
+	private:
+		using this_type = xml_reader_internal;
+
+	public:
+		static constexpr std::size_t default_buffer_size = std::size_t(1) << 20;
+
+	// -------------------------------------------------------------------------
+	//  constructors
+	//
+		explicit xml_reader_internal(const std::filesystem::path& path, std::string_view record_name = {}, std::size_t buffer_size = default_buffer_size);
+		explicit xml_reader_internal(std::istream& in, std::string_view record_name = {}, std::size_t buffer_size = default_buffer_size);
+		xml_reader_internal(const this_type&) = delete;
+		xml_reader_internal(this_type&&) noexcept;
+		~xml_reader_internal();
 
 	// -------------------------------------------------------------------------
 	//  assignments
 	//
+		this_type& operator =(const this_type&) = delete;
+		this_type& operator =(this_type&&) noexcept;
 
 	// -------------------------------------------------------------------------
-	//  get value
+	//  read
 	//
+		// next record, or an empty node at the end of the document
+		xml_node_internal next();
+
+	private:
+		std::unique_ptr<xml_reader_impl> pimpl_;
 
+	}; // class xml_reader_internal
+
+// -----------------------------------------------------------------------------
+//  xml_records_internal
+// -----------------------------------------------------------------------------
+	/*
+		Records, the children of the document element, parsed by multiple threads.
+		Record boundaries are found by a scan of markups, and chunks of records are parsed
+		in place on threads into independent documents. records() is in the order of the file,
+		and the results are the same for any number of threads.
+			const auto quotes = xml_records_internal::load_file("quotes.xml", "Quote");
+			for (const auto& quote : quotes.records()) {
+				const double rate = quote.attr("rate");
+			}
+
+		Children with record_name are records, or all children if record_name is empty.
+		threads is the number of worker threads, and 0 means std::thread::hardware_concurrency.
+		Records are parsed as standalone fragments, so the document must be UTF-8,
+		entities declared in DOCTYPE are not expanded, and the document element is not parsed.
+		Files are loaded and lifetime rules are as for xml_doc_internal.
+	*/
+	class xml_records_internal {
+	private:
+		using this_type = xml_records_internal;
+
+	public:
 	// -------------------------------------------------------------------------
-	//  get node
+	//  constructors
 	//
+		xml_records_internal() noexcept;
+		xml_records_internal(const this_type&) = delete;
+		xml_records_internal(this_type&&) noexcept;
+		~xml_records_internal();
+
+		static this_type load_file(const std::filesystem::path& path, std::string_view record_name = {}, std::size_t threads = 0);
+		static this_type load_string(std::string_view xml, std::string_view record_name = {}, std::size_t threads = 0);
 
 	// -------------------------------------------------------------------------
-	//  node update
+	//  assignments
 	//
+		this_type& operator =(const this_type&) = delete;
+		this_type& operator =(this_type&&) noexcept;
+
+	// -------------------------------------------------------------------------
+	//  get node
+	//
+		span<const xml_node_internal> records() const noexcept;
 
 	private:
-		std::unique_ptr<xml_node_impl> pimpl_ = nullptr;
+		explicit xml_records_internal(std::unique_ptr<xml_records_impl> pimpl) noexcept;
 
-	}; // class xml_node_internal
+	private:
+		std::unique_ptr<xml_records_impl> pimpl_;
+
+	}; // class xml_records_internal
 
 }}} // namespace qsb::xml::impl_layer
@@ -0,0 +1,44 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/bitmap.h"
+
+TEST(Bitmap, Access) {
+	qsb::util::bitmap b(70);
+	EXPECT_EQ(b.size(), 70u);
+	EXPECT_EQ(b.word_count(), 2u);
+	EXPECT_TRUE(b.none());
+
+	b.set(0);
+	b.set(69);
+	EXPECT_TRUE(b.test(0));
+	EXPECT_TRUE(b[69]);
+	EXPECT_FALSE(b.test(1));
+	EXPECT_EQ(b.count(), 2u);
+
+	b.reset(0);
+	EXPECT_FALSE(b.test(0));
+	EXPECT_EQ(b.count(), 1u);
+}
+
+TEST(Bitmap, Resize) {
+	qsb::util::bitmap b(3, true);
+	EXPECT_TRUE(b.all());
+	EXPECT_EQ(b.word(0), 7u);
+
+	b.resize(100, true);
+	EXPECT_TRUE(b.all());
+	EXPECT_EQ(b.count(), 100u);
+
+	b.resize(10);
+	EXPECT_EQ(b.count(), 10u);
+	b.resize(20);
+	EXPECT_EQ(b.count(), 10u);
+
+	b.assign(65, false);
+	EXPECT_TRUE(b.none());
+	b.set_word(1, ~qsb::util::bitmap::word_type(0));
+	EXPECT_EQ(b.count(), 1u);	// bits beyond size are ignored
+
+	EXPECT_EQ(qsb::util::bitmap(5, true), qsb::util::bitmap(5, true));
+	EXPECT_NE(qsb::util::bitmap(5, true), qsb::util::bitmap(6, true));
+}
@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/date.h"
+#include "../../nksand/core/utility/to_str.h"
+
+TEST(Date, FromString) {
+	using errc = qsb::traits::from_string_errc;
+	using trait = qsb::traits::from_string_trait<qsb::date>;
+
+	const auto d = qsb::util::from_string<qsb::date>("2024-03-15");
+	EXPECT_EQ(d.serial(), 19797);
+	EXPECT_EQ(d.year(), 2024);
+	EXPECT_EQ(d.month(), 3u);
+	EXPECT_EQ(d.day(), 15u);
+	EXPECT_EQ(qsb::util::from_str<qsb::date>("20240315"), d);
+	EXPECT_EQ(qsb::util::from_str<qsb::date>("1970-01-01").serial(), 0);
+	EXPECT_EQ(qsb::util::from_str<qsb::date>("19691231").serial(), -1);
+	EXPECT_EQ(qsb::util::from_str<qsb::date>("2000-02-29"), qsb::date(2000, 2, 29));
+
+	qsb::date x = qsb::date::from_serial(42);
+	EXPECT_EQ(trait::try_apply("2023-02-29", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("1900-02-29", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("2024-13-01", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("2024-00-01", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("2024-04-31", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("2024-04-00", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("2024/03/15", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("2024-3-15", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("2024031", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("2024-03-1x", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("", x), errc::invalid_argument);
+	EXPECT_EQ(x.serial(), 42);
+
+	qsb::date lazy = qsb::util::lazy_from_str("2024-03-15");
+	EXPECT_EQ(lazy, d);
+	qsb::optional<qsb::date> maybe = qsb::util::lazy_from_str(std::string_view("2024-02-30"));
+	EXPECT_FALSE(maybe.has_value());
+}
+
+TEST(Date, ToString) {
+	EXPECT_EQ(qsb::util::to_string(qsb::date(2024, 3, 15)), "2024-03-15");
+	EXPECT_EQ(qsb::util::to_string(qsb::date(2024, 2, 28) + 1), "2024-02-29");
+	EXPECT_EQ(qsb::date(2025, 1, 1) - qsb::date(2024, 1, 1), 366);
+}
+
+TEST(Date, MatchesCivilCalendar) {
+	// every day from 1600 to 2400 round trips through strings
+	char buffer[32];
+	for (std::int32_t serial = qsb::date(1600, 1, 1).serial(); serial < qsb::date(2400, 1, 1).serial(); ++serial) {
+		const auto d = qsb::date::from_serial(serial);
+		std::snprintf(buffer, sizeof(buffer), "%04d%02u%02u", static_cast<int>(d.year()), d.month(), d.day());
+		qsb::date parsed;
+		ASSERT_TRUE(qsb::util::try_from_string(buffer, parsed)) << buffer;
+		ASSERT_EQ(parsed, d) << buffer;
+		ASSERT_EQ(qsb::util::from_string<qsb::date>(d.to_string()), d);
+	}
+}
+
+TEST(Date, Batch) {
+	const std::vector<std::string_view> fields = {
+		"2024-03-15", "20240316", "2024-02-30", "", "x", "1999-12-31",
+	};
+	std::vector<qsb::date> dates(fields.size());
+	qsb::util::bitmap valid;
+	EXPECT_EQ(qsb::util::from_string_batch<qsb::date>(fields, dates, valid), 3u);
+	EXPECT_TRUE(valid.test(0));
+	EXPECT_FALSE(valid.test(2));
+	EXPECT_EQ(dates[1], qsb::date(2024, 3, 16));
+	EXPECT_EQ(dates[5], qsb::date(1999, 12, 31));
+}
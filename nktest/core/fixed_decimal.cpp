@@ -0,0 +1,87 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/fixed_decimal.h"
+
+TEST(FixedDecimal, FromString) {
+	using rate = qsb::fixed_decimal<1, 6>;
+	using errc = qsb::traits::from_string_errc;
+	using trait = qsb::traits::from_string_trait<rate>;
+
+	const auto r = qsb::util::from_string<rate>("0.012345");
+	EXPECT_EQ(r.scaled(), 12345);
+	EXPECT_EQ(r.to_double(), 0.012345);
+	EXPECT_EQ(r.to_string(), "0.012345");
+	EXPECT_EQ(qsb::util::from_str<rate>("-1.500000").scaled(), -1500000);
+	EXPECT_EQ(qsb::util::from_str<rate>("+1.500000").scaled(), 1500000);
+
+	rate x = rate::from_scaled(42);
+	EXPECT_EQ(trait::try_apply("0.01234", x), errc::invalid_argument);		// too few fraction digits
+	EXPECT_EQ(trait::try_apply("0.0123456", x), errc::invalid_argument);	// too many fraction digits
+	EXPECT_EQ(trait::try_apply("10.012345", x), errc::invalid_argument);	// too many integer digits
+	EXPECT_EQ(trait::try_apply(".012345", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("0,012345", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("0.01a345", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("1e-2", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("", x), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("-", x), errc::invalid_argument);
+	EXPECT_EQ(x.scaled(), 42);
+	EXPECT_ANY_THROW(qsb::util::from_string<rate>("0.1"));
+
+	using price = qsb::fixed_decimal<3, 4>;
+	EXPECT_EQ(qsb::util::from_string<price>("99.8750").to_double(), 99.875);
+	EXPECT_EQ(qsb::util::from_string<price>("5.0000").to_string(), "5.0000");
+	EXPECT_EQ(qsb::util::from_string<price>("-0.0001").to_string(), "-0.0001");
+	EXPECT_TRUE(qsb::util::from_string<price>("1.0000") < qsb::util::from_string<price>("1.0001"));
+
+	using count = qsb::fixed_decimal<5, 0>;
+	EXPECT_EQ(qsb::util::from_string<count>("12345").scaled(), 12345);
+	EXPECT_EQ(qsb::util::from_string<count>("7").to_string(), "7");
+	EXPECT_FALSE(qsb::util::safe_from_string<count>("7.").has_value());
+}
+
+TEST(FixedDecimal, ToDoubleMatchesStrtod) {
+	using wide = qsb::fixed_decimal<8, 8>;
+	std::mt19937_64 engine(42);
+	char buffer[32];
+	for (int i = 0; i < 100000; ++i) {
+		const auto scaled = static_cast<std::int64_t>(engine() % 10000000000000000ull) * (engine() % 2 ? 1 : -1);
+		std::snprintf(buffer, sizeof(buffer), "%s%lld.%08lld", scaled < 0 ? "-" : "",
+			static_cast<long long>(std::llabs(scaled) / 100000000), static_cast<long long>(std::llabs(scaled) % 100000000));
+
+		wide value;
+		ASSERT_TRUE(qsb::util::try_from_string(buffer, value)) << buffer;
+		ASSERT_EQ(value.scaled(), scaled) << buffer;
+		const double expected = std::strtod(buffer, nullptr);
+		const double actual = value.to_double();
+		ASSERT_EQ(std::memcmp(&actual, &expected, sizeof(double)), 0) << buffer;
+		if (scaled != 0) {
+			ASSERT_EQ(value.to_string(), buffer);
+		}
+	}
+}
+
+TEST(FixedDecimal, Batch) {
+	using price = qsb::fixed_decimal<3, 4>;
+	const std::vector<std::string_view> fields = {
+		"99.8750", "100.1250", "x", "-0.5000", "1000.0000", "1.000", "", "7.1234", "12.3456",
+	};
+	std::vector<price> values(fields.size());
+	qsb::util::bitmap valid;
+	EXPECT_EQ(qsb::util::from_string_batch<price>(fields, values, valid), 5u);
+	for (std::size_t i = 0; i < fields.size(); ++i) {
+		price expected;
+		EXPECT_EQ(qsb::util::try_from_string(fields[i], expected), valid.test(i)) << fields[i];
+		if (valid.test(i)) {
+			EXPECT_EQ(values[i], expected) << fields[i];
+		}
+	}
+	EXPECT_EQ(values[1].scaled(), 1001250);
+	EXPECT_EQ(values[3].scaled(), -5000);
+}
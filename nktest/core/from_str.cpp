@@ -0,0 +1,467 @@
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/from_str.h"
+
+namespace qtest {
+	struct throwing_parsable {
+		int i;
+		static throwing_parsable from_string(const char* str)
+		{
+			return {std::stoi(str)};
+		}
+	};
+
+	struct try_parsable {
+		int i;
+		static try_parsable from_string(const char* str)
+		{
+			try_parsable result {};
+			if (!try_from_string(str, result)) {
+				throw std::invalid_argument("not 42");
+			}
+			return result;
+		}
+		static bool try_from_string(const char* str, try_parsable& out)
+		{
+			if (std::string(str) != "42") {
+				return false;
+			}
+			out.i = 42;
+			return true;
+		}
+	};
+
+
+	struct counted_parsable {
+		static std::atomic<int> count;
+		int i;
+		static bool try_from_string(const char* str, counted_parsable& out)
+		{
+			++count;
+			return qsb::util::try_from_string(str, out.i);
+		}
+		static counted_parsable from_string(const char* str)
+		{
+			counted_parsable result {};
+			if (!try_from_string(str, result)) {
+				throw std::invalid_argument("not an integer");
+			}
+			return result;
+		}
+	};
+	std::atomic<int> counted_parsable::count { 0 };
+
+	// conversions of literals are compile time constants
+	using namespace qsb::literals;
+	static_assert(qsb::util::from_str<int>("42") == 42);
+	static_assert(qsb::util::from_string<unsigned long long>("18446744073709551615") == 18446744073709551615ull);
+	static_assert(qsb::util::from_str<double>("0.0025") == 0.0025);
+	static_assert(qsb::util::from_str<double>("-1.5e-300") == -1.5e-300);	// beyond the fast path
+	static_assert(qsb::util::from_str<double>("4.9406564584124654e-324") == 4.9406564584124654e-324);
+	static_assert(qsb::util::from_str<float>("3.4028235e38") == 3.4028235e38f);
+	static_assert(qsb::util::constant_from_str<long long>("-9223372036854775808") == -9223372036854775807ll - 1);
+	static_assert(qsb::util::lazy_from_str("42").as_int() == 42);
+	static_assert(qsb::util::lazy_from_str(std::string_view("2.5")).as_double() == 2.5);
+
+	constexpr int literal_int = "42"_from_str;
+	constexpr double literal_double = "0.5"_from_str;
+	static_assert(literal_int == 42 && literal_double == 0.5);
+
+	constexpr bool try_from_str_in_constexpr()
+	{
+		int x = 0;
+		return !qsb::util::try_from_str("4x", x) && qsb::util::try_from_str("7", x) && x == 7;
+	}
+	static_assert(try_from_str_in_constexpr());
+} // namespace qtest
+
+TEST(FromStr, FromString) {
+	EXPECT_EQ(qsb::util::from_string<int>("42"), 42);
+	EXPECT_EQ(qsb::util::from_string<long long>("-42"), -42);
+	EXPECT_DOUBLE_EQ(qsb::util::from_string<double>("0.0125"), 0.0125);
+	EXPECT_EQ(qsb::util::from_string<std::string>("42"), "42");
+	EXPECT_EQ(qsb::util::from_string<qtest::throwing_parsable>("42").i, 42);
+
+	EXPECT_THROW(qsb::util::from_string<int>("N/A"), std::invalid_argument);
+	EXPECT_THROW(qsb::util::from_string<double>(""), std::invalid_argument);
+	EXPECT_THROW(qsb::util::from_string<long>("99999999999999999999999"), std::invalid_argument);
+}
+
+TEST(FromStr, TryApply) {
+	using errc = qsb::traits::from_string_errc;
+	int i = 24;
+	EXPECT_EQ(qsb::traits::from_string_trait<int>::try_apply("42", i), errc::ok);
+	EXPECT_EQ(i, 42);
+	EXPECT_EQ(qsb::traits::from_string_trait<int>::try_apply("-", i), errc::invalid_argument);
+	EXPECT_EQ(i, 42);
+
+	long l = 24;
+	EXPECT_EQ(qsb::traits::from_string_trait<long>::try_apply("99999999999999999999999", l), errc::out_of_range);
+	EXPECT_EQ(l, 24);
+}
+
+TEST(FromStr, SafeFromString) {
+	EXPECT_EQ(qsb::util::safe_from_string<int>("42").value(), 42);
+	EXPECT_FALSE(qsb::util::safe_from_string<int>("N/A"));
+	EXPECT_FALSE(qsb::util::safe_from_string<double>("-"));
+	EXPECT_FALSE(qsb::util::safe_from_string<double>(""));
+
+	// fallback to try-catch
+	EXPECT_EQ(qsb::util::safe_from_string<qtest::throwing_parsable>("42").value().i, 42);
+	EXPECT_FALSE(qsb::util::safe_from_string<qtest::throwing_parsable>("N/A"));
+
+	// non-throwing member function
+	EXPECT_EQ(qsb::util::safe_from_string<qtest::try_parsable>("42").value().i, 42);
+	EXPECT_FALSE(qsb::util::safe_from_string<qtest::try_parsable>("24"));
+}
+
+TEST(FromStr, TryFromString) {
+	int i = 24;
+	EXPECT_TRUE(qsb::util::try_from_string("42", i));
+	EXPECT_EQ(i, 42);
+	EXPECT_FALSE(qsb::util::try_from_string("N/A", i));
+	EXPECT_EQ(i, 42);	// untouched
+
+	qtest::throwing_parsable tp {24};
+	EXPECT_TRUE(qsb::util::try_from_string("42", tp));
+	EXPECT_EQ(tp.i, 42);
+	EXPECT_FALSE(qsb::util::try_from_string("N/A", tp));
+	EXPECT_EQ(tp.i, 42);
+
+	qtest::try_parsable p {24};
+	EXPECT_FALSE(qsb::util::try_from_string("24", p));
+	EXPECT_EQ(p.i, 24);
+	EXPECT_TRUE(qsb::util::try_from_string("42", p));
+	EXPECT_EQ(p.i, 42);
+
+	qsb::optional<int> maybe_i;
+	EXPECT_TRUE(qsb::util::try_from_string("N/A", maybe_i));	// optional never fails
+	EXPECT_FALSE(maybe_i);
+}
+
+TEST(FromStr, ConvertibleString) {
+	const auto lazy = qsb::util::lazy_from_str("42");
+	const int i = lazy;
+	const double d = lazy;
+	const qsb::optional<int> maybe_i = lazy;
+	EXPECT_EQ(i, 42);
+	EXPECT_DOUBLE_EQ(d, 42.0);
+	EXPECT_EQ(maybe_i.value(), 42);
+	EXPECT_FALSE(qsb::util::lazy_from_str("N/A").maybe_int());
+}
+
+TEST(FromStr, StringView) {
+	// fields in a buffer without null terminator
+	const std::string_view buffer = "42,0.0125,N/A,abc";
+	const auto field = [&buffer](std::size_t pos, std::size_t len) { return buffer.substr(pos, len); };
+
+	EXPECT_EQ(qsb::util::from_string<int>(field(0, 2)), 42);
+	EXPECT_EQ(qsb::util::from_string<int>(field(0, 1)), 4);
+	EXPECT_DOUBLE_EQ(qsb::util::from_string<double>(field(3, 6)), 0.0125);
+	EXPECT_EQ(qsb::util::from_string<std::string>(field(14, 3)), "abc");
+	EXPECT_THROW(qsb::util::from_string<int>(field(10, 3)), std::invalid_argument);
+	EXPECT_EQ(qsb::util::from_string<qtest::throwing_parsable>(field(0, 2)).i, 42);
+
+	EXPECT_EQ(qsb::util::safe_from_string<int>(field(0, 2)).value(), 42);
+	EXPECT_FALSE(qsb::util::safe_from_string<int>(field(10, 3)));
+	EXPECT_FALSE(qsb::util::safe_from_string<qtest::try_parsable>(field(10, 3)));
+	EXPECT_EQ(qsb::util::safe_from_string<qtest::try_parsable>(field(0, 2)).value().i, 42);
+
+	int i = 24;
+	EXPECT_TRUE(qsb::util::try_from_string(field(0, 2), i));
+	EXPECT_EQ(i, 42);
+	EXPECT_FALSE(qsb::util::try_from_string(field(10, 3), i));
+	EXPECT_EQ(i, 42);
+
+	const std::string str = "42";
+	EXPECT_EQ(qsb::util::from_string<int>(str), 42);
+
+	const auto lazy = qsb::util::lazy_from_str(field(3, 6));
+	static_assert(std::is_same_v<decltype(lazy), const qsb::util::convertible_string<std::string_view>>, "");
+	const double d = lazy;
+	const std::string s = lazy;
+	EXPECT_DOUBLE_EQ(d, 0.0125);
+	EXPECT_EQ(s, "0.0125");
+	EXPECT_FALSE(qsb::util::lazy_from_str(field(10, 3)).maybe_double());
+}
+
+TEST(FromStr, Integer) {
+	using errc = qsb::traits::from_string_errc;
+	const auto parse = [](const char* str, auto& out) {
+		using trait = qsb::traits::from_string_trait<std::remove_reference_t<decltype(out)>>;
+		return trait::try_apply(str, out);
+	};
+
+	short s = 0;
+	EXPECT_EQ(parse("32767", s), errc::ok);
+	EXPECT_EQ(s, 32767);
+	EXPECT_EQ(parse("-32768", s), errc::ok);
+	EXPECT_EQ(s, -32768);
+	EXPECT_EQ(parse("32768", s), errc::out_of_range);
+	EXPECT_EQ(parse("-32769", s), errc::out_of_range);
+	EXPECT_EQ(s, -32768);
+
+	std::int8_t i8 = 0;
+	EXPECT_EQ(parse("-128", i8), errc::ok);
+	EXPECT_EQ(i8, -128);
+	EXPECT_EQ(parse("128", i8), errc::out_of_range);
+
+	unsigned u = 0;
+	EXPECT_EQ(parse("4294967295", u), errc::ok);
+	EXPECT_EQ(u, 4294967295u);
+	EXPECT_EQ(parse("4294967296", u), errc::out_of_range);
+	EXPECT_EQ(parse("-1", u), errc::invalid_argument);
+	EXPECT_EQ(parse("+42", u), errc::ok);
+	EXPECT_EQ(u, 42u);
+
+	long long ll = 0;
+	EXPECT_EQ(parse("9223372036854775807", ll), errc::ok);
+	EXPECT_EQ(ll, std::numeric_limits<long long>::max());
+	EXPECT_EQ(parse("-9223372036854775808", ll), errc::ok);
+	EXPECT_EQ(ll, std::numeric_limits<long long>::min());
+	EXPECT_EQ(parse("9223372036854775808", ll), errc::out_of_range);
+	EXPECT_EQ(parse("-00000000000000000000000042", ll), errc::ok);
+	EXPECT_EQ(ll, -42);
+
+	unsigned long long ull = 0;
+	EXPECT_EQ(parse("18446744073709551615", ull), errc::ok);
+	EXPECT_EQ(ull, std::numeric_limits<unsigned long long>::max());
+	EXPECT_EQ(parse("18446744073709551616", ull), errc::out_of_range);
+	EXPECT_EQ(parse("99999999999999999999", ull), errc::out_of_range);
+
+	// whole field must be a number
+	int i = 24;
+	EXPECT_EQ(parse("", i), errc::invalid_argument);
+	EXPECT_EQ(parse("-", i), errc::invalid_argument);
+	EXPECT_EQ(parse("+", i), errc::invalid_argument);
+	EXPECT_EQ(parse(" 42", i), errc::invalid_argument);
+	EXPECT_EQ(parse("42 ", i), errc::invalid_argument);
+	EXPECT_EQ(parse("42abc", i), errc::invalid_argument);
+	EXPECT_EQ(parse("0x2A", i), errc::invalid_argument);
+	EXPECT_EQ(parse("--42", i), errc::invalid_argument);
+	EXPECT_EQ(i, 24);
+}
+
+TEST(FromStr, Float) {
+	using errc = qsb::traits::from_string_errc;
+	const auto parse = [](const char* str, auto& out) {
+		using trait = qsb::traits::from_string_trait<std::remove_reference_t<decltype(out)>>;
+		return trait::try_apply(str, out);
+	};
+
+	double d = 0.0;
+	EXPECT_EQ(parse("0.0125", d), errc::ok);
+	EXPECT_EQ(d, 0.0125);
+	EXPECT_EQ(parse("-3.75e-4", d), errc::ok);
+	EXPECT_EQ(d, -3.75e-4);
+	EXPECT_EQ(parse("1.7976931348623157e308", d), errc::ok);
+	EXPECT_EQ(d, std::numeric_limits<double>::max());
+	EXPECT_EQ(parse("4.9406564584124654e-324", d), errc::ok);
+	EXPECT_EQ(d, std::numeric_limits<double>::denorm_min());
+	EXPECT_EQ(parse("9007199254740993", d), errc::ok);		// halfway, round to even
+	EXPECT_EQ(d, 9007199254740992.0);
+	EXPECT_EQ(parse("-0", d), errc::ok);
+	EXPECT_TRUE(std::signbit(d));
+	EXPECT_EQ(parse("-inf", d), errc::ok);
+	EXPECT_EQ(d, -std::numeric_limits<double>::infinity());
+	EXPECT_EQ(parse("NaN", d), errc::ok);
+	EXPECT_TRUE(std::isnan(d));
+
+	d = 42.0;
+	EXPECT_EQ(parse("1e400", d), errc::out_of_range);
+	EXPECT_EQ(parse("1e-400", d), errc::out_of_range);
+	EXPECT_EQ(parse("", d), errc::invalid_argument);
+	EXPECT_EQ(parse(".", d), errc::invalid_argument);
+	EXPECT_EQ(parse("1e", d), errc::invalid_argument);
+	EXPECT_EQ(parse(" 1.5", d), errc::invalid_argument);
+	EXPECT_EQ(parse("1.5x", d), errc::invalid_argument);
+	EXPECT_EQ(parse("N/A", d), errc::invalid_argument);
+	EXPECT_EQ(d, 42.0);
+
+	float f = 0.0f;
+	EXPECT_EQ(parse("0.1", f), errc::ok);
+	EXPECT_EQ(f, 0.1f);
+	EXPECT_EQ(parse("3.4028235e38", f), errc::ok);
+	EXPECT_EQ(f, std::numeric_limits<float>::max());
+	EXPECT_EQ(parse("1e39", f), errc::out_of_range);
+
+	long double ld = 0.0L;
+	EXPECT_EQ(parse("0.5", ld), errc::ok);
+	EXPECT_EQ(ld, 0.5L);
+}
+
+TEST(FromStr, FloatMatchesStrtod) {
+	std::mt19937_64 engine(42);
+	char buffer[64];
+	for (int i = 0; i < 100000; ++i) {
+		std::uint64_t bits = engine();
+		double expected;
+		std::memcpy(&expected, &bits, sizeof(double));
+		if (!std::isfinite(expected)) {
+			continue;
+		}
+		std::snprintf(buffer, sizeof(buffer), "%.*g", static_cast<int>(engine() % 20 + 1), expected);
+		expected = std::strtod(buffer, nullptr);
+		if (expected == 0.0 || !std::isfinite(expected)) {
+			continue;	// rounded to out of range
+		}
+
+		double actual = 0.0;
+		ASSERT_TRUE(qsb::util::try_from_string(buffer, actual)) << buffer;
+		ASSERT_EQ(std::memcmp(&actual, &expected, sizeof(double)), 0) << buffer;
+	}
+}
+
+TEST(FromStr, Batch) {
+	const std::vector<std::string_view> fields = {
+		"1.5", "x", "-2", "", "0.0125", "1e3", "-0", "12345678901234567890", "+.5", "5.", "inf", "1.2.3",
+	};
+	std::vector<double> values(fields.size(), 42.0);
+	qsb::util::bitmap valid;
+	EXPECT_EQ(qsb::util::from_string_batch<double>(fields, values, valid), 9u);
+	ASSERT_EQ(valid.size(), fields.size());
+	EXPECT_TRUE(valid.test(0));
+	EXPECT_EQ(values[0], 1.5);
+	EXPECT_FALSE(valid.test(1));
+	EXPECT_EQ(values[1], 42.0);
+	EXPECT_EQ(values[2], -2.0);
+	EXPECT_FALSE(valid.test(3));
+	EXPECT_EQ(values[4], 0.0125);
+	EXPECT_EQ(values[5], 1000.0);
+	EXPECT_TRUE(std::signbit(values[6]));
+	EXPECT_EQ(values[7], 12345678901234567890.0);
+	EXPECT_EQ(values[8], 0.5);
+	EXPECT_EQ(values[9], 5.0);
+	EXPECT_TRUE(std::isinf(values[10]));
+	EXPECT_FALSE(valid.test(11));
+
+	std::vector<int> ints(fields.size(), 42);
+	EXPECT_EQ(qsb::util::from_str_batch<int>(fields, ints, valid), 2u);
+	EXPECT_EQ(ints[2], -2);
+	EXPECT_EQ(ints[6], 0);
+	EXPECT_EQ(ints[0], 42);
+
+	std::vector<qsb::optional<int>> maybe_ints(fields.size());
+	EXPECT_EQ(qsb::util::from_string_batch<qsb::optional<int>>(fields, maybe_ints, valid), fields.size());
+	EXPECT_EQ(*maybe_ints[2], -2);
+	EXPECT_FALSE(maybe_ints[1].has_value());
+
+	std::vector<std::string> strs(fields.size());
+	EXPECT_EQ(qsb::util::from_string_batch<std::string>(fields, strs, valid), fields.size());
+	EXPECT_EQ(strs[1], "x");
+
+	std::vector<double> short_values(1);
+	EXPECT_ANY_THROW(qsb::util::from_string_batch<double>(fields, short_values, valid));
+}
+
+TEST(FromStr, BatchMatchesTryFromString) {
+	std::mt19937_64 engine(42);
+	const char alphabet[] = "0123456789.-+e";
+	std::vector<std::string> storage;
+	for (int i = 0; i < 20000; ++i) {
+		std::string field;
+		const std::size_t length = engine() % 20;
+		for (std::size_t k = 0; k < length; ++k) {
+			// mostly digits
+			const auto r = engine() % 32;
+			field += r < 26 ? alphabet[r % 10] : alphabet[10 + r % 4];
+		}
+		storage.push_back(field);
+	}
+	const std::vector<std::string_view> fields(storage.begin(), storage.end());
+
+	auto check = [&fields](auto dummy) {
+		using value_type = decltype(dummy);
+		std::vector<value_type> values(fields.size());
+		qsb::util::bitmap valid;
+		const std::size_t count = qsb::util::from_string_batch<value_type>(fields, values, valid);
+		EXPECT_EQ(count, valid.count());
+		for (std::size_t i = 0; i < fields.size(); ++i) {
+			value_type expected {};
+			ASSERT_EQ(qsb::util::try_from_string(fields[i], expected), valid.test(i)) << fields[i];
+			if (valid.test(i)) {
+				ASSERT_EQ(std::memcmp(&values[i], &expected, sizeof(value_type)), 0) << fields[i];
+			}
+		}
+	};
+	check(double{});
+	check(float{});
+	check(0);
+	check(std::uint16_t{});
+	check(0LL);
+}
+
+TEST(FromStr, CachedConvertibleString) {
+	using qtest::counted_parsable;
+	counted_parsable::count = 0;
+
+	const auto x = qsb::util::lazy_from_str("42").cached();
+	counted_parsable a = x;
+	counted_parsable b = x;
+	qsb::optional<counted_parsable> c = x;
+	EXPECT_EQ(a.i, 42);
+	EXPECT_EQ(b.i, 42);
+	EXPECT_EQ(c->i, 42);
+	EXPECT_EQ(counted_parsable::count, 1);
+
+	const int i = x;
+	const double d = x;
+	const std::string s = x;
+	EXPECT_EQ(i, 42);
+	EXPECT_EQ(d, 42.0);
+	EXPECT_EQ(s, "42");
+	EXPECT_EQ(x.as_int(), 42);
+	EXPECT_EQ(x.maybe_double().value(), 42.0);
+
+	counted_parsable::count = 0;
+	const auto y = qsb::util::lazy_from_str(std::string("x")).cached();
+	EXPECT_ANY_THROW(y.as<counted_parsable>());
+	EXPECT_FALSE(y.maybe<counted_parsable>().has_value());
+	counted_parsable e {};
+	EXPECT_FALSE(y.try_set_into(e));
+	EXPECT_EQ(counted_parsable::count, 1);		// failure is memoized too
+	EXPECT_EQ(y.as<std::string>(), "x");
+
+	const auto z = y;	// copy starts with empty cache
+	EXPECT_FALSE(z.maybe<counted_parsable>().has_value());
+	EXPECT_EQ(counted_parsable::count, 2);
+}
+
+TEST(FromStr, CachedConvertibleStringConcurrent) {
+	using qtest::counted_parsable;
+	for (int trial = 0; trial < 100; ++trial) {
+		counted_parsable::count = 0;
+		const auto x = qsb::util::lazy_from_str(std::string_view("42")).cached();
+		std::vector<std::thread> threads;
+		std::atomic<int> failures { 0 };
+		for (int t = 0; t < 4; ++t) {
+			threads.emplace_back([&x, &failures] {
+				for (int k = 0; k < 100; ++k) {
+					const counted_parsable p = x;
+					const double d = x;
+					const qsb::optional<long> l = x;
+					if (p.i != 42 || d != 42.0 || *l != 42) {
+						++failures;
+					}
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		EXPECT_EQ(failures, 0);
+		EXPECT_LE(counted_parsable::count, 4);	// racing threads may parse, but only one result is published
+	}
+}
@@ -1,6 +1,12 @@
 #include <type_traits>
+#include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <utility>
+#include <vector>
 #include "gtest/gtest.h"
+#include "../../nksand/core/utility/from_str.h"
 #include "../../nksand/core/utility/optional.h"
 
 TEST(Optional, HasValue) {
@@ -161,3 +167,275 @@ TEST(Optional, OperatorSupport) {
 	EXPECT_EQ(qtest::get_opt(21, true) | twice_opt | validator | twice /= 42, 84);
 	EXPECT_EQ(qtest::get_opt(21, true) | twice_opt | overwriter | twice /= 42, 84);
 }
+
+namespace qtest {
+	enum class quote_id : std::int32_t {};
+
+} // namespace qtest
+
+namespace qsb { namespace traits {
+	template <>
+	struct optional_niche<qtest::quote_id> : sentinel_niche<qtest::quote_id, qtest::quote_id{ -1 }> {};
+
+	template <>
+	struct optional_niche<const qtest::quote_id*> : sentinel_niche<const qtest::quote_id*, nullptr> {};
+
+}} // namespace qsb::traits
+
+namespace qtest {
+	// heavy payload which counts copies, moves and allocations by copies
+	struct tracked {
+		static inline int copies = 0;
+		static inline int moves = 0;
+		static inline int allocations = 0;
+		static void reset() { copies = 0; moves = 0; allocations = 0; }
+
+		int value = 0;
+		std::vector<double> payload;
+
+		explicit tracked(int v) : value(v), payload(64, 1.0) {}
+		tracked(std::vector<double> p) : value(static_cast<int>(p.size())), payload(std::move(p)) {}
+		tracked(const tracked& other) : value(other.value), payload(other.payload) { count_copy(); }
+		tracked(tracked&& other) noexcept : value(other.value), payload(std::move(other.payload)) { ++moves; }
+		tracked& operator=(const tracked& other) { value = other.value; payload = other.payload; count_copy(); return *this; }
+		tracked& operator=(tracked&& other) noexcept { value = other.value; payload = std::move(other.payload); ++moves; return *this; }
+
+	private:
+		void count_copy()
+		{
+			++copies;
+			allocations += payload.empty() ? 0 : 1;
+		}
+	};
+
+} // namespace qtest
+
+TEST(Optional, Lazy) {
+	using qsb::opt_helpers::lazy;
+	const auto twice_opt = [](int x) { return qsb::optional<int>(2 * x); };
+	const auto twice = [](int x) { return 2 * x; };
+	const auto validator = []{ throw "optional has not value"; };
+
+	int i = 0;
+	const auto overwriter = [&i]{ return ++i; };
+
+	// same results as the eager pipe
+	EXPECT_FALSE((lazy(qtest::get_opt(21, false)) | twice | twice_opt).eval());
+	EXPECT_FALSE((lazy(qtest::get_opt(21, false)) | twice_opt | twice).eval());
+	EXPECT_EQ(lazy(qtest::get_opt(21, false)) | twice_opt | twice /= 42, 42);
+	EXPECT_ANY_THROW(lazy(qtest::get_opt(21, false)) | twice_opt | validator | twice);
+	EXPECT_EQ(lazy(qtest::get_opt(21, false)) | twice_opt | overwriter | twice /= 42, 2);
+	EXPECT_ANY_THROW((lazy(qtest::get_opt(21, false)) | twice).value());
+
+	EXPECT_EQ((lazy(qtest::get_opt(21, true)) | twice | twice_opt).eval().value(), 84);
+	EXPECT_EQ(lazy(qtest::get_opt(21, true)) | twice_opt | validator | twice /= 42, 84);
+	EXPECT_EQ(lazy(qtest::get_opt(21, true)) | twice | twice | twice /= 0, 168);
+	EXPECT_EQ((lazy(qtest::get_opt(21, true)) | twice_opt | twice).value(), 84);
+	EXPECT_EQ(lazy(qtest::get_opt(21, true)) | [](int) { return qsb::optional<int>(); } | twice /= 1, 1);
+
+	const qsb::optional<int> source(21);
+	const qsb::optional<double> converted = lazy(source) | twice | [](int x) { return x / 4.0; };
+	EXPECT_EQ(converted.value(), 10.5);
+	EXPECT_EQ(source.value(), 21);
+
+	// stages are fused, so the value is not copied or moved between them
+	const auto add = [](qtest::tracked&& c) { c.value += 1; return std::move(c); };
+	qtest::tracked::reset();
+	const auto eager = qsb::optional<qtest::tracked>(qtest::tracked(1)) | add | add | add /= qtest::tracked(0);
+	const int eager_moves = qtest::tracked::moves;
+	qtest::tracked::reset();
+	const auto fused = lazy(qsb::optional<qtest::tracked>(qtest::tracked(1))) | add | add | add /= qtest::tracked(0);
+	EXPECT_EQ(eager.value, 4);
+	EXPECT_EQ(fused.value, 4);
+	EXPECT_EQ(qtest::tracked::copies, 0);
+	EXPECT_LT(qtest::tracked::moves, eager_moves);
+}
+
+namespace qtest {
+	// counts since the last reset, as {copies, moves}
+	inline std::pair<int, int> tracked_counts()
+	{
+		const std::pair<int, int> result(tracked::copies, tracked::moves);
+		tracked::reset();
+		return result;
+	}
+
+} // namespace qtest
+
+TEST(Optional, CopyCount) {
+	using counts = std::pair<int, int>;
+	using opt_t = qsb::optional<qtest::tracked>;
+	qtest::tracked value(1);
+	qtest::tracked::reset();
+
+	// constructors
+	{
+		opt_t copied(value);
+		EXPECT_EQ(qtest::tracked_counts(), counts(1, 0));
+		opt_t moved(qtest::tracked(2));
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+		opt_t in_place(qsb::in_place, 3);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 0));
+		opt_t copy_constructed(in_place);
+		EXPECT_EQ(qtest::tracked_counts(), counts(1, 0));
+		opt_t move_constructed(std::move(in_place));
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+
+		// converting constructors move the payload of rvalues
+		qsb::optional<std::vector<double>> source(std::vector<double>(16, 1.0));
+		const double* data = source->data();
+		opt_t converted(std::move(source));
+		EXPECT_EQ(converted->payload.data(), data);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 0));
+		EXPECT_FALSE(opt_t(qsb::optional<std::vector<double>>()));
+	}
+
+	// assignments
+	{
+		opt_t target;
+		target = qtest::tracked(2);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+		target = qtest::tracked(3);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+		target = value;
+		EXPECT_EQ(qtest::tracked_counts(), counts(1, 0));
+
+		opt_t other(qsb::in_place, 4);
+		qtest::tracked::reset();
+		target = other;
+		EXPECT_EQ(qtest::tracked_counts(), counts(1, 0));
+		target = std::move(other);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+
+		qsb::optional<std::vector<double>> source(std::vector<double>(16, 1.0));
+		const double* data = source->data();
+		target = std::move(source);
+		EXPECT_EQ(target->payload.data(), data);
+		EXPECT_EQ(target->value, 16);
+		target = qsb::optional<std::vector<double>>();
+		EXPECT_FALSE(target);
+		target = qsb::optional<std::vector<double>>(std::vector<double>(8, 1.0));
+		EXPECT_EQ(target->value, 8);
+		qtest::tracked::reset();
+	}
+
+	// monadic operations and pipes on rvalues move the payload only
+	const auto pass = [](qtest::tracked&& t) { ++t.value; return std::move(t); };
+	const auto pass_opt = [](qtest::tracked&& t) { ++t.value; return opt_t(std::move(t)); };
+	const auto peek = [](const qtest::tracked& t) { return t.value; };
+	const auto fallback = [] { return qtest::tracked(0); };
+	{
+		EXPECT_EQ(opt_t(qsb::in_place, 1).transform(pass)->value, 2);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 2));
+		EXPECT_EQ(opt_t(qsb::in_place, 1).and_then(pass_opt)->value, 2);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+		EXPECT_EQ(opt_t(qsb::in_place, 1).or_else(fallback)->value, 1);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+		EXPECT_EQ(opt_t().or_else(fallback)->value, 0);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+		EXPECT_EQ((opt_t(qsb::in_place, 1) /= qtest::tracked(0)).value, 1);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 1));
+
+		// a chain costs a constant number of moves per stage, independent of the payload
+		const auto chain = opt_t(qsb::in_place, 1) | pass | pass_opt | fallback | pass /= qtest::tracked(0);
+		EXPECT_EQ(chain.value, 4);
+		EXPECT_EQ(qtest::tracked::allocations, 0);
+		const auto chain_counts = qtest::tracked_counts();
+		EXPECT_EQ(chain_counts.first, 0);
+		EXPECT_LE(chain_counts.second, 8);
+	}
+
+	// lvalues are not copied unless an optional of the value is returned
+	{
+		opt_t source(qsb::in_place, 1);
+		const opt_t& const_source = source;
+		qtest::tracked::reset();
+		EXPECT_EQ(source.transform(peek).value(), 1);
+		EXPECT_EQ(const_source.transform(peek).value(), 1);
+		EXPECT_EQ((source | peek /= 0), 1);
+		EXPECT_EQ((const_source | [&](const qtest::tracked& t) { return opt_t(qsb::in_place, t.value); })->value, 1);
+		EXPECT_EQ(qtest::tracked_counts(), counts(0, 0));
+
+		EXPECT_EQ(source.or_else(fallback)->value, 1);
+		EXPECT_EQ(qtest::tracked_counts(), counts(1, 0));
+		EXPECT_EQ((const_source /= qtest::tracked(0)).value, 1);
+		EXPECT_EQ(qtest::tracked_counts(), counts(1, 0));
+	}
+}
+
+TEST(Optional, Niche) {
+	static_assert(sizeof(qsb::optional<double>) == sizeof(double));
+	static_assert(sizeof(qsb::optional<float>) == sizeof(float));
+	static_assert(sizeof(qsb::optional<const qtest::quote_id*>) == sizeof(const qtest::quote_id*));
+	static_assert(sizeof(qsb::optional<qtest::quote_id>) == sizeof(qtest::quote_id));
+	static_assert(sizeof(qsb::optional<int>) > sizeof(int));
+	static_assert(sizeof(qsb::optional<int*>) > sizeof(int*));
+	static_assert(std::is_trivially_copyable_v<qsb::optional<double>>);
+
+	// literal types as with tl::optional
+	constexpr qsb::optional<double> c(1.5);
+	static_assert(c.has_value() && *c == 1.5);
+	static_assert(!qsb::optional<double>().has_value());
+	static_assert(!qsb::optional<float>(qsb::nullopt).has_value());
+	static_assert(qsb::optional<float>(0.5f).value() == 0.5f);
+	static_assert((qsb::optional<double>() /= 2.0) == 2.0);
+	static_assert(qsb::optional<qtest::quote_id>(qtest::quote_id{ 7 }).has_value());
+	constexpr qsb::optional<double> od = qsb::util::lazy_from_str("4.5");
+	static_assert(od.value() == 4.5);
+
+	qsb::optional<double> x;
+	EXPECT_FALSE(x);
+	EXPECT_ANY_THROW(x.value());
+	EXPECT_EQ(x /= 1.5, 1.5);
+	x = 0.25;
+	EXPECT_TRUE(x);
+	EXPECT_EQ(*x, 0.25);
+	x = qsb::nullopt;
+	EXPECT_FALSE(x.has_value());
+
+	// NaNs made by arithmetic are values
+	const qsb::optional<double> nan(std::numeric_limits<double>::quiet_NaN());
+	EXPECT_TRUE(nan.has_value());
+	const qsb::optional<double> inf_minus_inf(std::numeric_limits<double>::infinity() - std::numeric_limits<double>::infinity());
+	EXPECT_TRUE(inf_minus_inf.has_value());
+
+	// monadic and pipe
+	const auto twice = [](double v) { return 2 * v; };
+	const auto positive = [](double v) { return v > 0 ? qsb::optional<double>(v) : qsb::optional<double>(); };
+	EXPECT_EQ(qsb::optional<double>(21.0) | twice | positive /= 0.0, 42.0);
+	EXPECT_EQ(qsb::optional<double>(-21.0) | twice | positive /= 0.0, 0.0);
+	EXPECT_EQ(qsb::optional<double>() | twice /= 1.0, 1.0);
+	EXPECT_EQ(qsb::optional<double>(0.5).transform([](double v) { return static_cast<int>(2 * v); }).value(), 1);
+
+	// conversion between niche and flagged storages
+	const qsb::optional<int> i(qsb::optional<double>(2.0));
+	EXPECT_EQ(*i, 2);
+	const qsb::optional<double> d(qsb::optional<int>(3));
+	EXPECT_EQ(*d, 3.0);
+	EXPECT_FALSE(qsb::optional<double>(qsb::optional<int>()));
+
+	// nullptr is a value of pointers without a declared niche
+	int value = 42;
+	qsb::optional<int*> p(&value);
+	EXPECT_EQ(**p, 42);
+	p = nullptr;
+	EXPECT_TRUE(p);
+	EXPECT_EQ(*p, nullptr);
+	p.reset();
+	EXPECT_FALSE(p);
+	p.emplace(nullptr);
+	EXPECT_TRUE(p.has_value());
+
+	const qtest::quote_id quote{ 3 };
+	qsb::optional<const qtest::quote_id*> q(&quote);
+	EXPECT_EQ(**q, quote);
+	q = nullptr;
+	EXPECT_FALSE(q);
+
+	qsb::optional<qtest::quote_id> id(qtest::quote_id{ 7 });
+	EXPECT_EQ(*id, qtest::quote_id{ 7 });
+	id.reset();
+	EXPECT_FALSE(id);
+	id.emplace(qtest::quote_id{ 8 });
+	EXPECT_EQ(id.value(), qtest::quote_id{ 8 });
+}
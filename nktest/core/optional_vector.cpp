@@ -0,0 +1,116 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/optional_vector.h"
+
+namespace qtest {
+	inline bool same(const qsb::optional<double>& l, const qsb::optional<double>& r)
+	{
+		return l.has_value() == r.has_value() && (!l || *l == *r);
+	}
+
+	// value whose copy throws if it is marked
+	struct throwing_copy {
+		int value = 0;
+
+		throwing_copy() = default;
+		explicit throwing_copy(int v) : value(v) {}
+		throwing_copy(const throwing_copy& other) : value(other.value)
+		{
+			if (value < 0) {
+				throw std::runtime_error("copy failed");
+			}
+		}
+		throwing_copy& operator=(const throwing_copy&) = default;
+	};
+
+} // namespace qtest
+
+TEST(OptionalVector, Access) {
+	qsb::optional_vector<double> rates = { qsb::optional<double>(0.01), qsb::nullopt, qsb::optional<double>(0.02) };
+	EXPECT_EQ(rates.size(), 3u);
+	EXPECT_EQ(rates.count(), 2u);
+	EXPECT_TRUE(rates[0]);
+	EXPECT_FALSE(rates[1]);
+	EXPECT_EQ(*rates[2], 0.02);
+	EXPECT_ANY_THROW(rates[1].value());
+
+	rates[1] = 0.015;
+	EXPECT_EQ(rates[1].value(), 0.015);
+	rates[0] = qsb::nullopt;
+	EXPECT_FALSE(rates.has_value(0));
+	rates[0] = rates[2];
+	EXPECT_EQ(rates[0].value_or(0.0), 0.02);
+
+	const qsb::optional<double> x = rates[1];
+	EXPECT_EQ(*x, 0.015);
+
+	const auto& crates = rates;
+	const qsb::optional<double> y = crates[2] | [](double r) { return r * 2; };
+	EXPECT_EQ(*y, 0.04);
+
+	rates.push_back(0.03);
+	rates.push_back(qsb::nullopt);
+	EXPECT_EQ(rates.size(), 5u);
+	EXPECT_EQ(rates.count(), 4u);
+	EXPECT_EQ(rates.validity().size(), 5u);
+
+	EXPECT_ANY_THROW(qsb::optional_vector<int>(std::vector<int>(3), qsb::util::bitmap(2)));
+
+	// sizes of values and validity are kept the same when a push_back throws
+	qsb::optional_vector<qtest::throwing_copy> values;
+	values.reserve(100);
+	for (int i = 0; i < 70; ++i) {
+		values.push_back(qtest::throwing_copy(i));
+	}
+	const qtest::throwing_copy bad(-1);
+	EXPECT_THROW(values.push_back(bad), std::runtime_error);
+	EXPECT_EQ(values.size(), 70u);
+	EXPECT_EQ(values.validity().size(), 70u);
+	EXPECT_EQ(values.count(), 70u);
+	values.push_back(qsb::nullopt);
+	EXPECT_EQ(values.validity().size(), 71u);
+	EXPECT_FALSE(values.has_value(70));
+}
+
+TEST(OptionalVector, Bulk) {
+	std::mt19937_64 engine(42);
+	std::vector<qsb::optional<double>> expected;
+	qsb::optional_vector<double> values;
+	for (int i = 0; i < 1000; ++i) {
+		// long runs of valid elements and scattered invalid ones
+		const bool valid = (i / 200) % 2 == 0 || engine() % 3 != 0;
+		const double value = static_cast<double>(i) - 500.0;
+		expected.push_back(valid ? qsb::optional<double>(value) : qsb::optional<double>());
+		values.push_back(expected.back());
+	}
+
+	const auto twice = [](double v) { return 2 * v; };
+	const auto positive = [](double v) { return v > 0 ? qsb::optional<double>(v) : qsb::optional<double>(); };
+
+	const auto twiced = values.transform(twice);
+	const auto positives = values.and_then(positive);
+	const std::vector<double> filled = values /= -1.0;
+	for (std::size_t i = 0; i < expected.size(); ++i) {
+		EXPECT_TRUE(qtest::same(twiced[i], expected[i] | twice)) << i;
+		EXPECT_TRUE(qtest::same(positives[i], expected[i] | positive)) << i;
+		EXPECT_EQ(filled[i], expected[i] /= -1.0) << i;
+	}
+
+	// unaligned view
+	const qsb::optional_span<const double> view = values.view().subspan(37, 500);
+	EXPECT_EQ(view.size(), 500u);
+	const auto sub = view.transform(twice);
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < view.size(); ++i) {
+		EXPECT_TRUE(qtest::same(sub[i], expected[37 + i] | twice)) << i;
+		count += expected[37 + i] ? 1 : 0;
+	}
+	EXPECT_EQ(view.count(), count);
+
+	values.view()[3] = qsb::nullopt;
+	EXPECT_FALSE(values[3]);
+}
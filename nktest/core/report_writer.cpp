@@ -0,0 +1,120 @@
+#include <cstddef>
+#include <ios>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/date.h"
+#include "../../nksand/core/utility/report_writer.h"
+
+namespace qtest {
+	struct df_row {
+		qsb::date date;
+		double df;
+	};
+
+	inline std::vector<df_row> make_df_rows(std::size_t size)
+	{
+		std::vector<df_row> rows;
+		for (std::size_t i = 0; i < size; ++i) {
+			rows.push_back({ qsb::date(2024, 1, 1) + static_cast<std::int32_t>(i), 1.0 / (1.0 + 0.0001 * static_cast<double>(i)) });
+		}
+		return rows;
+	}
+
+	inline void format_df_row(std::string& buffer, const df_row& row)
+	{
+		qsb::util::append_csv_row(buffer, row.date, qsb::util::to_string(row.df, 10, 0));
+	}
+
+	// stream buffer which fails after limit characters
+	class failing_buf : public std::streambuf {
+	public:
+		explicit failing_buf(std::size_t limit) : limit_(limit) {}
+
+	protected:
+		std::streamsize xsputn(const char*, std::streamsize count) override
+		{
+			const auto n = static_cast<std::size_t>(count) < limit_ ? static_cast<std::size_t>(count) : limit_;
+			limit_ -= n;
+			return static_cast<std::streamsize>(n);
+		}
+
+		int_type overflow(int_type) override { return traits_type::eof(); }
+
+	private:
+		std::size_t limit_;
+	};
+
+} // namespace qtest
+
+TEST(ReportWriter, CsvRow) {
+	std::string line;
+	qsb::util::append_csv_row(line, 1, "a", 0.5);
+	qsb::util::append_csv_row(line, qsb::date(2024, 3, 15));
+	EXPECT_EQ(line, "1,a,0.5\n2024-03-15\n");
+}
+
+TEST(ReportWriter, MatchesSequential) {
+	const auto rows = qtest::make_df_rows(40 * 365 + 7);
+
+	std::string expected;
+	for (const auto& row : rows) {
+		qtest::format_df_row(expected, row);
+	}
+
+	for (const std::size_t threads : { 1, 2, 8 }) {
+		for (const std::size_t rows_per_chunk : { 1, 100, 100000 }) {
+			qsb::util::report_options options;
+			options.threads = threads;
+			options.rows_per_chunk = rows_per_chunk;
+			options.chunks_in_flight = threads == 8 ? 3 : 0;
+
+			std::ostringstream out;
+			qsb::util::write_report(out, qsb::span<const qtest::df_row>(rows), qtest::format_df_row, options);
+			ASSERT_EQ(out.str(), expected) << threads << ' ' << rows_per_chunk;
+		}
+	}
+
+	std::ostringstream out;
+	qsb::util::write_report(out, qsb::span<const qtest::df_row>(), qtest::format_df_row);
+	EXPECT_EQ(out.str(), "");
+}
+
+TEST(ReportWriter, Exception) {
+	const auto rows = qtest::make_df_rows(1000);
+	qsb::util::report_options options;
+	options.threads = 4;
+	options.rows_per_chunk = 10;
+
+	std::ostringstream out;
+	const auto format = [](std::string& buffer, const qtest::df_row& row) {
+		if (row.date == qsb::date(2024, 1, 1) + 555) {
+			throw std::runtime_error("failed");
+		}
+		qtest::format_df_row(buffer, row);
+	};
+	EXPECT_THROW(qsb::util::write_report(out, qsb::span<const qtest::df_row>(rows), format, options), std::runtime_error);
+}
+
+TEST(ReportWriter, StreamException) {
+	const auto rows = qtest::make_df_rows(1000);
+	qsb::util::report_options options;
+	options.threads = 4;
+	options.rows_per_chunk = 10;
+
+	// failure reported by the stream state
+	qtest::failing_buf buf(1000);
+	std::ostream out(&buf);
+	EXPECT_NO_THROW(qsb::util::write_report(out, qsb::span<const qtest::df_row>(rows), qtest::format_df_row, options));
+	EXPECT_TRUE(out.bad());
+
+	// failure reported by an exception
+	qtest::failing_buf throwing_buf(1000);
+	std::ostream throwing_out(&throwing_buf);
+	throwing_out.exceptions(std::ios::badbit);
+	EXPECT_THROW(qsb::util::write_report(throwing_out, qsb::span<const qtest::df_row>(rows), qtest::format_df_row, options), std::ios::failure);
+}
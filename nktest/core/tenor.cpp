@@ -0,0 +1,59 @@
+#include <string>
+#include <type_traits>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/tenor.h"
+#include "../../nksand/core/utility/to_str.h"
+
+namespace qtest {
+	using namespace qsb::literals;
+	static_assert("3M"_tenor == qsb::tenor(3, qsb::tenor_unit::month));
+	static_assert("10y"_tenor == qsb::tenor(10, qsb::tenor_unit::year));
+	static_assert("ON"_tenor.unit() == qsb::tenor_unit::overnight);
+	static_assert("sw"_tenor.is_special());
+
+} // namespace qtest
+
+TEST(Tenor, FromString) {
+	using errc = qsb::traits::from_string_errc;
+	using trait = qsb::traits::from_string_trait<qsb::tenor>;
+
+	EXPECT_EQ(qsb::util::from_string<qsb::tenor>("1W"), qsb::tenor(1, qsb::tenor_unit::week));
+	EXPECT_EQ(qsb::util::from_string<qsb::tenor>("18M"), qsb::tenor(18, qsb::tenor_unit::month));
+	EXPECT_EQ(qsb::util::from_string<qsb::tenor>("1d"), qsb::tenor(1, qsb::tenor_unit::day));
+	EXPECT_EQ(qsb::util::from_string<qsb::tenor>("TN").unit(), qsb::tenor_unit::tomorrow_next);
+	EXPECT_EQ(qsb::util::from_string<qsb::tenor>("SN").unit(), qsb::tenor_unit::spot_next);
+	EXPECT_EQ(qsb::util::from_string<qsb::tenor>("on").unit(), qsb::tenor_unit::overnight);
+
+	qsb::tenor t(42, qsb::tenor_unit::day);
+	EXPECT_EQ(trait::try_apply("", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("M", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("3", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("3X", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("3 M", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("-3M", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("12345Y", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("OW", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("NO", t), errc::invalid_argument);
+	EXPECT_EQ(trait::try_apply("ON ", t), errc::invalid_argument);
+	EXPECT_EQ(t, qsb::tenor(42, qsb::tenor_unit::day));
+	EXPECT_ANY_THROW(qsb::util::from_string<qsb::tenor>("3X"));
+	EXPECT_FALSE(qsb::util::safe_from_string<qsb::tenor>("3X").has_value());
+
+	// member obeys the try_from_string protocol of from_str.h
+	static_assert(std::is_same_v<decltype(qsb::tenor::try_from_string("1M", t)), bool>);
+	EXPECT_TRUE(qsb::tenor::try_from_string("6M", t));
+	EXPECT_EQ(t, qsb::tenor(6, qsb::tenor_unit::month));
+	EXPECT_FALSE(qsb::tenor::try_from_string("6X", t));
+	EXPECT_EQ(t, qsb::tenor(6, qsb::tenor_unit::month));
+}
+
+TEST(Tenor, ToString) {
+	using namespace qsb::literals;
+	EXPECT_EQ(qsb::util::to_string("ON"_tenor), "ON");
+	EXPECT_EQ(qsb::util::to_string("tn"_tenor), "TN");
+	EXPECT_EQ(qsb::util::to_string("SW"_tenor), "SW");
+	EXPECT_EQ(qsb::util::to_string("10Y"_tenor), "10Y");
+	EXPECT_EQ(qsb::util::to_string("18m"_tenor), "18M");
+	EXPECT_EQ(qsb::util::to_string("1D"_tenor), "1D");
+	EXPECT_EQ(qsb::util::to_string("2W"_tenor), "2W");
+}
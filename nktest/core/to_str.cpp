@@ -0,0 +1,262 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/to_str.h"
+#include "../../nksand/core/utility/from_str.h"
+#include "../../nksand/core/utility/optional.h"
+
+namespace qtest {
+	struct to_chars_countable {
+		int value;
+	};
+
+	struct to_chars_count {
+		static inline int calls = 0;
+	};
+
+	struct adl_to_string_class {};
+	inline std::string to_string(const adl_to_string_class&) { return "adl"; }
+
+	struct quote {
+		double bid;
+		double ask;
+	};
+
+} // namespace qtest
+
+namespace qsb { namespace traits {
+	template <>
+	struct to_string_trait<qtest::to_chars_countable> {
+		static char* to_chars(char* first, char* last, const qtest::to_chars_countable& x) noexcept
+		{
+			++qtest::to_chars_count::calls;
+			return to_str_detail::copy_chars(first, last, x.value == 0 ? "zero" : "other");
+		}
+
+		static std::string apply(const qtest::to_chars_countable& x)
+		{
+			char buffer[8];
+			return std::string(buffer, to_chars(buffer, buffer + sizeof(buffer), x));
+		}
+	};
+
+
+	template <>
+	struct write_string_trait<qtest::quote> {
+		template <typename Sink>
+		static void write(Sink& sink, const qtest::quote& q)
+		{
+			util::append_to(sink, q.bid);
+			util::append_to(sink, "/");
+			util::append_to(sink, q.ask);
+		}
+	};
+
+}} // namespace qsb::traits
+
+TEST(ToStr, ToString) {
+	EXPECT_EQ(qsb::util::to_string(42), "42");
+	EXPECT_EQ(qsb::util::to_str(std::string("42")), "42");
+	EXPECT_EQ(qsb::util::to_string("42"), "42");
+	EXPECT_EQ(qsb::util::to_string(1.5, 2, 6), "  1.50");
+}
+
+namespace qtest {
+	template <typename T>
+	void expect_integer_limits()
+	{
+		for (const T value : { std::numeric_limits<T>::min(), T(std::numeric_limits<T>::min() + 1), T(0), T(1), T(9), T(10), T(99), T(100), std::numeric_limits<T>::max() }) {
+			EXPECT_EQ(qsb::util::to_string(value), std::to_string(value));
+		}
+	}
+
+} // namespace qtest
+
+TEST(ToStr, Integer) {
+	qtest::expect_integer_limits<signed char>();
+	qtest::expect_integer_limits<unsigned char>();
+	qtest::expect_integer_limits<short>();
+	qtest::expect_integer_limits<unsigned short>();
+	qtest::expect_integer_limits<int>();
+	qtest::expect_integer_limits<unsigned>();
+	qtest::expect_integer_limits<long>();
+	qtest::expect_integer_limits<unsigned long>();
+	qtest::expect_integer_limits<long long>();
+	qtest::expect_integer_limits<unsigned long long>();
+	EXPECT_EQ(qsb::util::to_string(true), "1");
+	EXPECT_EQ(qsb::util::to_string('A'), "65");
+
+	std::uint64_t power = 1;
+	for (int digits = 1; digits <= 20; ++digits, power *= 10) {
+		EXPECT_EQ(qsb::util::to_string(power), std::to_string(power));
+		EXPECT_EQ(qsb::util::to_string(power - 1), std::to_string(power - 1));
+	}
+
+	std::mt19937_64 engine(42);
+	for (int i = 0; i < 100000; ++i) {
+		const auto value = static_cast<long long>(engine() >> (engine() % 64));
+		ASSERT_EQ(qsb::util::to_string(value), std::to_string(value));
+		ASSERT_EQ(qsb::util::to_string(-value), std::to_string(-value));
+	}
+}
+
+TEST(ToStr, Float) {
+	EXPECT_EQ(qsb::util::to_string(0.1), "0.1");
+	EXPECT_EQ(qsb::util::to_string(1.2e-7), "1.2e-07");
+	EXPECT_EQ(qsb::util::to_string(0.99875), "0.99875");
+	EXPECT_EQ(qsb::util::to_string(100.0), "100");
+	EXPECT_EQ(qsb::util::to_string(1e20), "1e+20");
+	EXPECT_EQ(qsb::util::to_string(-0.0), "-0");
+	EXPECT_EQ(qsb::util::to_string(std::numeric_limits<double>::infinity()), "inf");
+	EXPECT_EQ(qsb::util::to_string(0.1f), "0.1");
+	EXPECT_EQ(qsb::util::to_string(1.0L), "1");
+}
+
+TEST(ToStr, FloatRoundTrip) {
+	std::mt19937_64 engine(42);
+	for (int i = 0; i < 100000; ++i) {
+		const std::uint64_t bits = engine();
+		double d;
+		std::memcpy(&d, &bits, sizeof(d));
+		if (std::isfinite(d)) {
+			const double parsed = qsb::util::from_string<double>(qsb::util::to_string(d));
+			ASSERT_EQ(std::memcmp(&parsed, &d, sizeof(d)), 0) << qsb::util::to_string(d);
+		}
+
+		const auto fbits = static_cast<std::uint32_t>(bits >> 32);
+		float f;
+		std::memcpy(&f, &fbits, sizeof(f));
+		if (std::isfinite(f)) {
+			const float parsed = qsb::util::from_string<float>(qsb::util::to_string(f));
+			ASSERT_EQ(std::memcmp(&parsed, &f, sizeof(f)), 0) << qsb::util::to_string(f);
+		}
+	}
+}
+
+TEST(ToStr, ToChars) {
+	char buffer[8];
+	char* const last = buffer + sizeof(buffer);
+	char* end = qsb::util::to_chars(buffer, last, 42);
+	EXPECT_EQ(std::string(buffer, end), "42");
+	end = qsb::util::to_chars(buffer, last, std::string("abc"));
+	EXPECT_EQ(std::string(buffer, end), "abc");
+	end = qsb::util::to_chars(buffer, last, "abc");
+	EXPECT_EQ(std::string(buffer, end), "abc");
+	end = qsb::util::to_chars(buffer, last, 0.25);
+	EXPECT_EQ(std::string(buffer, end), "0.25");
+	end = qsb::util::to_chars(buffer, last, 1.5, 2, 6);
+	EXPECT_EQ(std::string(buffer, end), "  1.50");
+	end = qsb::util::to_chars(buffer, last, 1.5, 2, -6);
+	EXPECT_EQ(std::string(buffer, end), "1.50  ");
+
+	// too short
+	EXPECT_EQ(qsb::util::to_chars(buffer, last, 123456789), nullptr);
+	EXPECT_EQ(qsb::util::to_chars(buffer, last, std::string("123456789")), nullptr);
+	EXPECT_EQ(qsb::util::to_chars(buffer, last, 1.5, 2, 9), nullptr);
+
+	qtest::to_chars_count::calls = 0;
+	end = qsb::util::to_chars(buffer, last, qtest::to_chars_countable{ 0 });
+	EXPECT_EQ(std::string(buffer, end), "zero");
+	EXPECT_EQ(qtest::to_chars_count::calls, 1);
+}
+
+TEST(ToStr, AppendTo) {
+	std::string line = "x=";
+	qsb::util::append_to(line, 42);
+	line += ',';
+	qsb::util::append_to(line, 0.25);
+	line += ',';
+	char* const end = qsb::util::append_to(line, 1.5, 2, 6);
+	EXPECT_EQ(line, "x=42,0.25,  1.50");
+	EXPECT_EQ(end, line.data() + line.size());
+
+	std::vector<char> chars;
+	qsb::util::append_to(chars, std::string(100, 'a'));
+	qsb::util::append_to(chars, qtest::to_chars_countable{ 1 });
+	EXPECT_EQ(std::string(chars.begin(), chars.end()), std::string(100, 'a') + "other");
+}
+
+TEST(ToStr, FixedMatchesSprintf) {
+	std::mt19937_64 engine(42);
+	std::uniform_real_distribution<double> mantissa(-10.0, 10.0);
+	std::uniform_int_distribution<int> exponent(-10, 40);
+	std::uniform_int_distribution<int> prec(-1, 12);
+	std::uniform_int_distribution<int> digits(-20, 20);
+	for (int i = 0; i < 100000; ++i) {
+		const double d = mantissa(engine) * std::pow(10.0, exponent(engine));
+		const int p = prec(engine);
+		const int w = digits(engine);
+
+		char expected[256];
+		if (d > 1.0e32 || d < -1.0e32) {
+			std::snprintf(expected, sizeof(expected), "%f", d);
+		}
+		else {
+			std::snprintf(expected, sizeof(expected), "%*.*f", w, p, d);
+		}
+		ASSERT_EQ(qsb::util::to_string(d, p, w), expected) << d << ' ' << p << ' ' << w;
+	}
+}
+
+TEST(ToStr, Composite) {
+	EXPECT_EQ(qsb::util::to_string(std::vector<int>{ 1, 2, 3 }), "[1, 2, 3]");
+	EXPECT_EQ(qsb::util::to_string(std::vector<int>{}), "[]");
+	EXPECT_EQ(qsb::util::to_string(std::make_pair(1, std::string("a"))), "(1, a)");
+	EXPECT_EQ(qsb::util::to_string(std::make_tuple(0.5, "b", 2u)), "(0.5, b, 2)");
+	EXPECT_EQ(qsb::util::to_string(std::map<std::string, double>{ { "1Y", 0.25 }, { "2Y", 0.5 } }), "[(1Y, 0.25), (2Y, 0.5)]");
+	EXPECT_EQ(qsb::util::to_string(qsb::optional<int>(42)), "42");
+	EXPECT_EQ(qsb::util::to_string(qsb::optional<int>()), "");
+	EXPECT_EQ(qsb::util::to_string(std::vector<qsb::optional<double>>{ qsb::optional<double>(1.5), qsb::optional<double>(), qsb::optional<double>(2.0) }), "[1.5, , 2]");
+	EXPECT_EQ(qsb::util::to_string(std::vector<qtest::adl_to_string_class>(2)), "[adl, adl]");
+	EXPECT_EQ(qsb::util::to_string(qtest::quote{ 99.5, 100.25 }), "99.5/100.25");
+	EXPECT_EQ(qsb::util::to_string(std::vector<qtest::quote>{ { 99.5, 100.25 }, { 1, 2 } }), "[99.5/100.25, 1/2]");
+
+	std::vector<char> chars;
+	qsb::util::append_to(chars, "x=");
+	qsb::util::append_to(chars, std::vector<std::vector<int>>{ { 1 }, { 2, 3 } });
+	EXPECT_EQ(std::string(chars.begin(), chars.end()), "x=[[1], [2, 3]]");
+
+	const std::vector<double> values(100, -1.2345678901234567e-100);
+	const std::string str = qsb::util::to_string(values);
+	EXPECT_LE(str.size(), qsb::traits::write_string_trait<std::vector<double>>::estimate_size(values));
+}
+
+TEST(ToStr, FixedBatch) {
+	const double dfs[] = { 1.0, 0.99875, 0.5 };
+	EXPECT_EQ(qsb::util::to_string_batch(dfs, 4, 0, ","), "1.0000,0.9988,0.5000");
+	EXPECT_EQ(qsb::util::to_string_batch(qsb::span<const double>(), 4, 0, ","), "");
+
+	std::mt19937_64 engine(42);
+	std::uniform_real_distribution<double> mantissa(-10.0, 10.0);
+	std::uniform_int_distribution<int> exponent(-20, 40);
+	std::vector<double> values(10000);
+	for (auto& value : values) {
+		value = mantissa(engine) * std::pow(10.0, exponent(engine));
+	}
+	values[0] = std::numeric_limits<double>::infinity();
+	values[1] = -0.0;
+	values[2] = 0.125;
+
+	for (const int prec : { 0, 2, 10, 19, 25 }) {
+		for (const int digits : { 0, -30, 30 }) {
+			std::string expected;
+			for (std::size_t i = 0; i < values.size(); ++i) {
+				expected += (i == 0 ? "" : " | ") + qsb::util::to_string(values[i], prec, digits);
+			}
+
+			std::vector<char> chars = { '>' };
+			char* const end = qsb::util::format_fixed_batch(chars, values, prec, digits, " | ");
+			EXPECT_EQ(end, chars.data() + chars.size());
+			ASSERT_EQ(std::string(chars.begin(), chars.end()), ">" + expected) << prec << ' ' << digits;
+		}
+	}
+}
@@ -0,0 +1,331 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../nksand/core/utility/date.h"
+#include "../../nksand/core/xml.h"
+
+namespace qtest {
+	inline const char* quotes_xml()
+	{
+		return
+			"<?xml version=\"1.0\"?>\n"
+			"<Quotes date=\"2024-03-15\">\n"
+			"  <!-- deposit rates -->\n"
+			"  <Quote id=\"USD-1M\" rate=\"0.0532\"/>\n"
+			"  <Quote id=\"USD-3M\" rate=\"0.0541\"/>\n"
+			"  <Note>rates &amp; spreads</Note>\n"
+			"  <Quote id=\"USD-6M\" rate=\"0.0550\"/>\n"
+			"</Quotes>\n";
+	}
+
+	// file in the temporary directory, removed at the end of scope
+	struct temp_file {
+		std::filesystem::path path;
+
+		temp_file(const std::string& name, std::string_view content)
+			: path(std::filesystem::temp_directory_path() / name)
+		{
+			std::ofstream out(path, std::ios::binary);
+			out.write(content.data(), static_cast<std::streamsize>(content.size()));
+		}
+
+		~temp_file()
+		{
+			std::error_code ec;
+			std::filesystem::remove(path, ec);
+		}
+	};
+
+	inline void expect_quotes(const qsb::xml::xml_doc& doc)
+	{
+		const auto root = doc.root();
+		ASSERT_TRUE(root);
+		EXPECT_EQ(root.name(), "Quotes");
+		EXPECT_EQ(root.attr("date").str(), "2024-03-15");
+
+		std::string ids;
+		for (auto quote = root.child("Quote"); quote; quote = quote.next_sibling("Quote")) {
+			ids += quote.attr("id").str();
+			ids += ';';
+		}
+		EXPECT_EQ(ids, "USD-1M;USD-3M;USD-6M;");
+
+		const auto note = root.child("Note");
+		EXPECT_EQ(note.text().str(), "rates & spreads");
+		EXPECT_EQ(note.parent().name(), "Quotes");
+		EXPECT_EQ(root.first_child().attr("rate").str(), "0.0532");
+		EXPECT_EQ(root.first_child().next_sibling().next_sibling().name(), "Note");
+	}
+
+} // namespace qtest
+
+TEST(Xml, LoadString) {
+	const auto doc = qsb::xml::xml_doc::load_string(qtest::quotes_xml());
+	qtest::expect_quotes(doc);
+
+	const auto quote = doc.root().child("Quote");
+	EXPECT_TRUE(quote.has_attr("rate"));
+	EXPECT_FALSE(quote.has_attr("ra"));
+	EXPECT_EQ(quote.attr("missing").str(), "");
+	EXPECT_FALSE(quote.child("Missing"));
+	EXPECT_FALSE(quote.first_child());
+	EXPECT_FALSE(doc.root().parent());
+	EXPECT_EQ(quote.child("Missing").next_sibling().name(), "");
+
+	EXPECT_FALSE(qsb::xml::xml_doc().root());
+}
+
+TEST(Xml, LoadFile) {
+	const qtest::temp_file file("nktest_xml_load_file.xml", qtest::quotes_xml());
+	auto doc = qsb::xml::xml_doc::load_file(file.path);
+	qtest::expect_quotes(doc);
+
+	// views and nodes are valid after the document is moved
+	const auto root = doc.root();
+	const std::string_view date = root.attr("date").str();
+	const auto moved = std::move(doc);
+	EXPECT_EQ(date, "2024-03-15");
+	EXPECT_EQ(root.child("Quote").attr("id").str(), "USD-1M");
+	qtest::expect_quotes(moved);
+
+	// the file is not modified by parsing in place
+	std::ifstream in(file.path, std::ios::binary);
+	const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	EXPECT_EQ(content, qtest::quotes_xml());
+}
+
+TEST(Xml, NodeHandle) {
+	static_assert(std::is_trivially_copyable_v<qsb::xml::xml_node>);
+	static_assert(sizeof(qsb::xml::xml_node) == sizeof(void*));
+
+	std::string xml = "<Quotes>";
+	for (int i = 0; i < 100000; ++i) {
+		xml += "<Quote id=\"Q" + std::to_string(i) + "\"/>";
+	}
+	xml += "</Quotes>";
+	const auto doc = qsb::xml::xml_doc::load_string(xml);
+
+	std::size_t count = 0;
+	std::size_t id_size = 0;
+	qsb::xml::xml_node last;
+	for (auto quote = doc.root().first_child(); quote; quote = quote.next_sibling()) {
+		++count;
+		id_size += quote.attr("id").str().size();
+		last = quote;
+	}
+	EXPECT_EQ(count, 100000u);
+	EXPECT_EQ(id_size, 10u * 2 + 90u * 3 + 900u * 4 + 9000u * 5 + 90000u * 6);
+	EXPECT_EQ(last.attr("id").str(), "Q99999");
+	EXPECT_EQ(last.parent(), doc.root());
+	EXPECT_NE(last, doc.root());
+	EXPECT_EQ(doc.root().child("Quote"), doc.root().first_child());
+	EXPECT_EQ(qsb::xml::xml_node(), last.next_sibling());
+}
+
+TEST(Xml, TypedValue) {
+	const auto doc = qsb::xml::xml_doc::load_string(
+		"<Deal trade_date=\"2024-03-15\" notional=\"1e6\" days=\"90\" flag=\"x\">"
+		"<Rate>0.0532</Rate><Maturity>2024-06-13</Maturity>"
+		"</Deal>");
+	const auto deal = doc.root();
+
+	EXPECT_EQ(deal.attr("notional").as<double>(), 1e6);
+	EXPECT_EQ(deal.attr("days").as_int(), 90);
+	EXPECT_EQ(deal.attr("trade_date").as<qsb::date>(), qsb::date(2024, 3, 15));
+	EXPECT_EQ(deal.child("Rate").text().as<double>(), 0.0532);
+	EXPECT_EQ(deal.child("Maturity").text().as<qsb::date>(), qsb::date(2024, 6, 13));
+
+	EXPECT_EQ(deal.attr("days").maybe<int>().value(), 90);
+	EXPECT_FALSE(deal.attr("flag").maybe<int>());
+	EXPECT_FALSE(deal.attr("missing").maybe<int>());
+	EXPECT_FALSE(deal.child("Missing").text().maybe<double>());
+	EXPECT_ANY_THROW(deal.attr("missing").as<double>());
+
+	// implicit conversions
+	const double rate = deal.child("Rate").text();
+	const qsb::optional<int> days = deal.attr("days");
+	const qsb::date maturity = deal.child("Maturity").text();
+	EXPECT_EQ(rate, 0.0532);
+	EXPECT_EQ(days.value(), 90);
+	EXPECT_EQ(maturity, qsb::date(2024, 6, 13));
+
+	// values view the characters in the document
+	EXPECT_EQ(deal.attr("days").str().data(), deal.attr("days").str().data());
+}
+
+namespace qtest {
+	inline std::string read_ids(qsb::xml::xml_reader& reader)
+	{
+		std::string ids;
+		while (const auto record = reader.next()) {
+			ids += record.attr("id").str();
+			ids += ';';
+		}
+		return ids;
+	}
+
+} // namespace qtest
+
+TEST(Xml, Reader) {
+	const std::string xml =
+		"<?xml version=\"1.0\"?>\n"
+		"<!DOCTYPE Quotes [ <!ELEMENT Quotes ANY> ]>\n"
+		"<Quotes date=\"2024-03-15\">\n"
+		"  <!-- <Quote id=\"commented\"/> -->\n"
+		"  <Quote id=\"USD-1M\" rate=\"0.0532\"/>\n"
+		"  <Quote id=\"a>b/\" rate='0.0541'><Source>broker &amp; screen</Source></Quote>\n"
+		"  <Note><![CDATA[<Quote id=\"cdata\"/>]]></Note>\n"
+		"  <Quote id=\"USD-6M\"><Quote id=\"nested\"/><Rate>0.0550</Rate></Quote>\n"
+		"</Quotes>\n";
+
+	for (const std::size_t buffer_size : { 1, 16, 100, 4096 }) {
+		std::istringstream in(xml);
+		qsb::xml::xml_reader reader(in, "Quote", buffer_size);
+
+		const auto first = reader.next();
+		EXPECT_EQ(first.name(), "Quote");
+		EXPECT_EQ(first.attr("rate").as<double>(), 0.0532);
+		const auto second = reader.next();
+		EXPECT_EQ(second.attr("id").str(), "a>b/");
+		EXPECT_EQ(second.child("Source").text().str(), "broker & screen");
+		const auto third = reader.next();
+		EXPECT_EQ(third.attr("id").str(), "USD-6M");
+		EXPECT_EQ(third.child("Quote").attr("id").str(), "nested");
+		EXPECT_EQ(third.child("Rate").text().as<double>(), 0.0550);
+		EXPECT_FALSE(reader.next());
+		EXPECT_FALSE(reader.next());
+
+		std::istringstream all(xml);
+		qsb::xml::xml_reader all_reader(all, "", buffer_size);
+		EXPECT_EQ(qtest::read_ids(all_reader), "USD-1M;a>b/;;USD-6M;") << buffer_size;
+	}
+
+	// large documents are read through the buffer
+	std::string large = "<Quotes>";
+	for (int i = 0; i < 10000; ++i) {
+		large += "<Quote id=\"Q" + std::to_string(i) + "\"><Rate>" + std::to_string(i) + "</Rate></Quote>\n";
+	}
+	large += "</Quotes>";
+	const qtest::temp_file file("nktest_xml_reader.xml", large);
+	qsb::xml::xml_reader reader(file.path, "Quote", 1024);
+	int count = 0;
+	long long sum = 0;
+	while (const auto quote = reader.next()) {
+		++count;
+		sum += quote.child("Rate").text().as<long long>();
+	}
+	EXPECT_EQ(count, 10000);
+	EXPECT_EQ(sum, 10000LL * 9999 / 2);
+
+	std::istringstream empty_root("<Quotes/>");
+	EXPECT_FALSE(qsb::xml::xml_reader(empty_root).next());
+}
+
+TEST(Xml, ReaderError) {
+	const auto read_all = [](const std::string& xml) {
+		std::istringstream in(xml);
+		qsb::xml::xml_reader reader(in, "", 16);
+		return qtest::read_ids(reader);
+	};
+	EXPECT_THROW(read_all("<Quotes><Quote id=\"1\"/>"), std::runtime_error);
+	EXPECT_THROW(read_all("<Quotes><Quote id=\"1\"><Rate></Quotes>"), std::runtime_error);
+	EXPECT_THROW(read_all("<Quotes><Quote id=\"1"), std::runtime_error);
+	EXPECT_THROW(read_all("<Quotes/><Quotes/>"), std::runtime_error);
+	EXPECT_THROW(read_all("</Quotes>"), std::runtime_error);
+	EXPECT_THROW(read_all(""), std::runtime_error);
+	try {
+		qsb::xml::xml_reader reader(std::filesystem::temp_directory_path() / "nktest_xml_missing.xml");
+		ADD_FAILURE();
+	}
+	catch (const std::system_error& e) {
+		EXPECT_EQ(e.code(), std::errc::no_such_file_or_directory);
+	}
+}
+
+TEST(Xml, Records) {
+	std::string xml = "<?xml version=\"1.0\"?>\n<Quotes date=\"2024-03-15\">\n";
+	for (int i = 0; i < 20000; ++i) {
+		xml += "  <Quote id=\"Q" + std::to_string(i) + "\"><Rate>" + std::to_string(i) + "</Rate></Quote>\n";
+		if (i % 1000 == 0) {
+			xml += "  <!-- <Quote id=\"commented\"/> --><Note>&lt;Quote/&gt;</Note>\n";
+		}
+		if (i == 10000) {
+			// markups in a large comment and CDATA, across which segments are split
+			xml += "<!--";
+			xml += "<![CDATA[";
+			for (int j = 0; j < 5000; ++j) {
+				xml += "<Quote id=\"commented\"/></Quote>";
+			}
+			xml += "-->\n<Note><![CDATA[";
+			for (int j = 0; j < 5000; ++j) {
+				xml += "<Quote id=\"cdata\"><!--";
+			}
+			xml += "]]></Note>\n";
+		}
+	}
+	xml += "</Quotes>\n";
+
+	const auto doc = qsb::xml::xml_doc::load_string(xml);
+	std::vector<std::string> expected;
+	for (auto quote = doc.root().child("Quote"); quote; quote = quote.next_sibling("Quote")) {
+		expected.push_back(std::string(quote.attr("id").str()) + '=' + std::string(quote.child("Rate").text().str()));
+	}
+	ASSERT_EQ(expected.size(), 20000u);
+
+	const qtest::temp_file file("nktest_xml_records.xml", xml);
+	for (const std::size_t threads : { 1, 2, 8 }) {
+		const auto records = qsb::xml::xml_records::load_file(file.path, "Quote", threads);
+		ASSERT_EQ(records.records().size(), expected.size()) << threads;
+		for (std::size_t i = 0; i < expected.size(); ++i) {
+			const auto& quote = records.records()[i];
+			ASSERT_EQ(std::string(quote.attr("id").str()) + '=' + std::string(quote.child("Rate").text().str()), expected[i]) << threads;
+		}
+		EXPECT_FALSE(records.records()[0].parent());
+		EXPECT_EQ(records.records()[19999].child("Rate").text().as<int>(), 19999);
+	}
+
+	const auto all = qsb::xml::xml_records::load_string(xml, "", 4);
+	EXPECT_EQ(all.records().size(), 20000u + 21u);
+	EXPECT_EQ(all.records()[1].name(), "Note");
+	EXPECT_EQ(all.records()[1].text().str(), "<Quote/>");
+
+	EXPECT_EQ(qsb::xml::xml_records::load_string("<Quotes/>").records().size(), 0u);
+	EXPECT_EQ(qsb::xml::xml_records().records().size(), 0u);
+}
+
+TEST(Xml, RecordsError) {
+	std::string xml = "<Quotes>";
+	for (int i = 0; i < 1000; ++i) {
+		xml += i == 700 ? "<Quote><Rate></Quote>" : "<Quote><Rate>1</Rate></Quote>";
+	}
+	xml += "</Quotes>";
+	EXPECT_THROW(qsb::xml::xml_records::load_string(xml, "Quote", 4), std::runtime_error);
+	EXPECT_THROW(qsb::xml::xml_records::load_string("<Quotes><Quote>", "Quote", 4), std::runtime_error);
+	EXPECT_THROW(qsb::xml::xml_records::load_string("<Quotes><Quote id=\"1", "Quote", 4), std::runtime_error);
+	EXPECT_THROW(qsb::xml::xml_records::load_string("", "Quote", 4), std::runtime_error);
+
+	// records are parsed by pugixml, which checks names of end tags
+	std::string unbalanced = "<Quotes>";
+	for (int i = 0; i < 1000; ++i) {
+		unbalanced += i == 300 ? "<Quote><Rate></Spread></Quote>" : "<Quote/>";
+	}
+	unbalanced += "</Quotes>";
+	EXPECT_THROW(qsb::xml::xml_records::load_string(unbalanced, "Quote", 4), std::runtime_error);
+}
+
+TEST(Xml, Error) {
+	EXPECT_THROW(qsb::xml::xml_doc::load_file(std::filesystem::temp_directory_path() / "nktest_xml_missing.xml"), std::system_error);
+	EXPECT_THROW(qsb::xml::xml_doc::load_string("<Quotes><Quote></Quotes>"), std::runtime_error);
+	EXPECT_THROW(qsb::xml::xml_doc::load_string(""), std::runtime_error);
+
+	const qtest::temp_file empty("nktest_xml_empty.xml", "");
+	EXPECT_THROW(qsb::xml::xml_doc::load_file(empty.path), std::runtime_error);
+}